@@ -2,6 +2,7 @@
 #define AST_NODE_H
 
 #include "QualType.h"
+#include "rxc/AST/ConstantValue.h"
 #include "rxc/AST/TypeContext.h"
 #include "rxc/Basic/SourceManager.h"
 
@@ -13,6 +14,7 @@
 #include <llvm/ADT/Twine.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/ErrorHandling.h>
+#include <optional>
 
 namespace rx::sema {
 class LexicalScope;
@@ -142,7 +144,7 @@ public:
 
 private:
   std::string Symbol;
-  TypeDecl *DeclNode;
+  TypeDecl *DeclNode = nullptr;
 };
 
 class ASTAccessType : public ASTType {
@@ -460,10 +462,21 @@ public:
   std::string name() const override { return "VarDecl"; }
   Expression *getInitializer() const { return Initializer; }
 
+  // declared or deduced type, set by type checking
+  QualType getType() const { return Ty; }
+  void setType(QualType T) { Ty = T; }
+
+  // Whether the variable is assigned or its address taken anywhere, set by
+  // type checking.
+  bool isModified() const { return Modified; }
+  void setModified() { Modified = true; }
+
   ACCEPT_VISITOR(BaseDeclVisitor);
 
 private:
   Expression *Initializer;
+  QualType Ty;
+  bool Modified = false;
 };
 
 class FuncParamDecl;
@@ -499,8 +512,13 @@ public:
   std::string name() const override { return "FuncParamDecl"; }
   Expression *getDefaultValue() const { return DefaultValue; }
 
+  // declared type, set by type checking
+  QualType getType() const { return Ty; }
+  void setType(QualType T) { Ty = T; }
+
 private:
   Expression *DefaultValue;
+  QualType Ty;
 };
 
 class Stmt : public ASTNode {
@@ -595,8 +613,15 @@ public:
   QualType getExprType() const { return ExprType; }
   void setExprType(QualType Ty) { ExprType = Ty; }
 
+  // The value type checking folded the expression to, if it is constant.
+  const ConstantValue *getConstantValue() const {
+    return Value ? &*Value : nullptr;
+  }
+  void setConstantValue(std::optional<ConstantValue> V) { Value = std::move(V); }
+
 private:
   QualType ExprType;
+  std::optional<ConstantValue> Value;
 };
 
 class CallExpr : public Expression {
@@ -611,9 +636,14 @@ public:
   Expression *getCallee() const { return Callee; }
   llvm::ArrayRef<Expression *> getArgs() const { return Args; }
 
+  // The function the call resolves to, set once by type checking.
+  FuncDecl *getCalleeDecl() const { return CalleeDecl; }
+  void setCalleeDecl(FuncDecl *F) { CalleeDecl = F; }
+
 private:
   Expression *Callee;
   llvm::SmallVector<Expression *> Args;
+  FuncDecl *CalleeDecl = nullptr;
 };
 
 class AccessExpr : public Expression {
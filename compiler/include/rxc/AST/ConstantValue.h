@@ -0,0 +1,32 @@
+#ifndef RXC_AST_CONSTANT_VALUE_H
+#define RXC_AST_CONSTANT_VALUE_H
+
+#include <llvm/ADT/APFloat.h>
+#include <llvm/ADT/APSInt.h>
+#include <variant>
+
+namespace rx {
+
+// Value of an expression of builtin scalar type that is known at compile
+// time. Integers are held at the width of their type and i1 as an unsigned
+// 1 bit integer, floats in the semantics of their type, so lowering a value
+// needs no conversion.
+class ConstantValue {
+public:
+  explicit ConstantValue(llvm::APSInt Int) : V(std::move(Int)) {}
+  explicit ConstantValue(llvm::APFloat Float) : V(std::move(Float)) {}
+
+  bool isInt() const { return std::holds_alternative<llvm::APSInt>(V); }
+  bool isFloat() const { return std::holds_alternative<llvm::APFloat>(V); }
+
+  const llvm::APSInt &getInt() const { return std::get<llvm::APSInt>(V); }
+  const llvm::APFloat &getFloat() const { return std::get<llvm::APFloat>(V); }
+  bool getBool() const { return getInt().getBoolValue(); }
+
+private:
+  std::variant<llvm::APSInt, llvm::APFloat> V;
+};
+
+} // namespace rx
+
+#endif
@@ -52,12 +52,16 @@ public:
   ast::TypeDecl *getDecl() const { return Decl; };
   std::string getTypeName() const override;
   llvm::ArrayRef<ast::FuncDecl *> getImpls() const { return Impls; }
-  void addImpl(ast::FuncDecl *Func) { Impls.push_back(Func); }
+  // Methods of the given name, in the order their impls declare them.
+  llvm::ArrayRef<ast::FuncDecl *> getMethods(llvm::StringRef Name) const;
+  void addImpl(ast::FuncDecl *Func);
 
 private:
   ast::TypeDecl *Decl;
   QualType Definition;
   llvm::SmallVector<ast::FuncDecl *, 8> Impls;
+  // method calls look up their callee by name
+  llvm::StringMap<llvm::SmallVector<ast::FuncDecl *, 1>> Methods;
 };
 
 // Composite Types
@@ -70,6 +74,8 @@ class PointerType : public CompositeType {
 public:
   PointerType(QualType PointeeTy) : PointeeTy(PointeeTy) {}
 
+  QualType getPointeeType() const { return PointeeTy; }
+
   std::string getTypeName() const override {
     return "*" + PointeeTy.getTypeName();
   }
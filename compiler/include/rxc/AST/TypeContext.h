@@ -3,8 +3,10 @@
 
 #include "rxc/AST/QualType.h"
 #include "rxc/AST/Type.h"
+#include "rxc/AST/TypeLayout.h"
 #include <deque>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <unordered_set>
 
 namespace rx {
@@ -29,8 +31,26 @@ public:
   QualType getObjectType(llvm::StringMap<QualType> &&Fields);
   QualType getEnumType(llvm::StringMap<QualType> &&Members);
 
+  // The function type of the unqualified parameter types returning unit.
+  // It is uniqued like every other type, so functions of the same name
+  // overload each other iff their signatures are different pointers.
+  const FuncType *getSignature(llvm::ArrayRef<QualType> ParamTys);
+
   void addImpl(ast::TypeDecl *Decl, ast::FuncDecl *Func);
 
+  // Layout of an object or enum type, computed on the first request.
+  // Returns nullptr if a field or payload has no storage.
+  const ObjectLayout *getObjectLayout(const ObjectType *Ty);
+  const EnumLayout *getEnumLayout(const EnumType *Ty);
+
+  // Type checking records the object types whose fields are assigned to.
+  void addMutatedObject(const ObjectType *Ty) { MutatedObjects.insert(Ty); }
+  // Objects that are never mutated, hold no gc pointer and fit in two
+  // eightbytes have no identity. Codegen passes them around as values and
+  // boxes them only where they are stored into the heap. Only meaningful
+  // once every program is type checked.
+  bool isValueType(const ObjectType *Ty);
+
 private:
   // leaf types
   std::deque<BuiltinType> BuiltinCtx;
@@ -42,6 +62,11 @@ private:
   std::unordered_set<FuncType> FuncCtx;
   std::unordered_set<ObjectType> ObjCtx;
   std::unordered_set<EnumType> EnumCtx;
+
+  // nullptr for types without a layout
+  llvm::DenseMap<const ObjectType *, std::unique_ptr<ObjectLayout>> LayoutCtx;
+  llvm::DenseMap<const EnumType *, std::unique_ptr<EnumLayout>> EnumLayoutCtx;
+  llvm::DenseSet<const ObjectType *> MutatedObjects;
 };
 } // namespace rx
 
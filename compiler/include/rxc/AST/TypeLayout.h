@@ -0,0 +1,135 @@
+#ifndef RXC_AST_TYPE_LAYOUT_H
+#define RXC_AST_TYPE_LAYOUT_H
+
+#include "rxc/AST/QualType.h"
+
+#include <cstdint>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <optional>
+
+namespace rx {
+
+class EnumType;
+class ObjectType;
+
+// Size and alignment of a value of some type when it is stored in memory,
+// for the 64 bit targets the runtime supports. References into the gc heap
+// are a pointer each.
+struct StorageInfo {
+  uint64_t Size;
+  uint64_t Align;
+  bool IsGCPointer;
+};
+
+// Storage of types that have a representation. Named types take the storage
+// of their definition, unit and functions have none.
+std::optional<StorageInfo> getStorageInfo(QualType Ty);
+
+struct FieldLayout {
+  llvm::StringRef Name;
+  QualType Type;
+  uint64_t Offset;
+  uint64_t Size;
+  uint64_t Align;
+  bool IsGCPointer;
+};
+
+// Payload layout of an object type. Fields are reordered: gc pointers come
+// first, so the heap map of an object is the single range [0,
+// getGCPointersEnd()), and the other fields follow by decreasing alignment,
+// which needs no padding between them. Fields of the same alignment keep
+// the order of their names, so layouts do not depend on hashing.
+class ObjectLayout {
+public:
+  // Returns std::nullopt if a field has no storage.
+  static std::optional<ObjectLayout> compute(const ObjectType &Ty);
+
+  uint64_t getSize() const { return Size; }
+  uint64_t getAlignment() const { return Align; }
+
+  // Fields in memory order.
+  llvm::ArrayRef<FieldLayout> getFields() const { return Fields; }
+  const FieldLayout *getField(llvm::StringRef Name) const;
+
+  unsigned getNumGCPointers() const { return NumGCPointers; }
+  uint64_t getGCPointersEnd() const {
+    return NumGCPointers ? Fields[NumGCPointers - 1].Offset + 8 : 0;
+  }
+
+private:
+  ObjectLayout() = default;
+
+private:
+  uint64_t Size = 0;
+  uint64_t Align = 1;
+  unsigned NumGCPointers = 0;
+  llvm::SmallVector<FieldLayout, 8> Fields;
+};
+
+// Representation of an enum type. Members are numbered by the order of
+// their names from 0, so the tags of an enum are dense and a match on them
+// lowers to a switch that LLVM can emit as a jump table. Values of an enum
+// never hold a gc pointer next to other data, statepoints can only relocate
+// pointers that are values of their own.
+class EnumLayout {
+public:
+  enum class Kind {
+    // No member has a payload, the value is the tag.
+    Tag,
+    // One member with a gc pointer payload and one without any payload. The
+    // value is the pointer, null stands for the other member.
+    NullablePointer,
+    // No payload is a gc pointer. The value holds the largest payload
+    // followed by the tag.
+    Inline,
+    // The value is a gc pointer to a box of the gc pointer payloads, which
+    // share the slot at offset 0, the other payloads and the tag. The slot
+    // is null unless a member with a gc pointer payload is stored.
+    Boxed,
+  };
+
+  struct Member {
+    llvm::StringRef Name;
+    // unit for members without a payload
+    QualType Payload;
+    uint32_t Tag;
+    bool IsGCPointer;
+  };
+
+  // Returns std::nullopt if a payload has no storage.
+  static std::optional<EnumLayout> compute(const EnumType &Ty);
+
+  Kind getKind() const { return K; }
+  // Storage of a value of the enum.
+  StorageInfo getStorage() const;
+
+  llvm::ArrayRef<Member> getMembers() const { return Members; }
+  const Member *getMember(llvm::StringRef Name) const;
+
+  uint64_t getTagSize() const { return TagSize; }
+  // Offsets in the value for Inline and in the box for Boxed; the size of
+  // either is getDataSize().
+  uint64_t getPayloadOffset(const Member &M) const;
+  uint64_t getTagOffset() const { return TagOffset; }
+  uint64_t getDataSize() const { return DataSize; }
+  uint64_t getDataAlignment() const { return DataAlign; }
+
+private:
+  EnumLayout() = default;
+
+private:
+  Kind K = Kind::Tag;
+  uint64_t TagSize = 1;
+  uint64_t TagOffset = 0;
+  // offset of the payloads that are not gc pointers
+  uint64_t ScalarOffset = 0;
+  uint64_t DataSize = 0;
+  uint64_t DataAlign = 1;
+  llvm::SmallVector<Member, 8> Members;
+};
+
+} // namespace rx
+
+#endif
@@ -42,7 +42,13 @@ public:
   ConsoleDiagnosticConsumer() {}
 
 public:
-  void emit(Diagnostic &&D) override { printMessageHeader(D); };
+  void emit(Diagnostic &&D) override {
+    if (D.kind() == Diagnostic::Type::Error)
+      ++NumErrors;
+    printMessageHeader(D);
+  };
+
+  unsigned getNumErrors() const { return NumErrors; }
 
 private:
   void printMessageHeader(const Diagnostic &D);
@@ -51,6 +57,8 @@ private:
   static llvm::raw_ostream &PrintDiagnosticType(Diagnostic::Type Type);
   static llvm::raw_ostream &PadLineNumber(llvm::raw_ostream &Os, size_t Num,
                                           int PrefixLen = 4);
+
+  unsigned NumErrors = 0;
 };
 } // namespace rx
 
@@ -0,0 +1,58 @@
+#ifndef RXC_CODEGEN_BACKEND_H
+#define RXC_CODEGEN_BACKEND_H
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <memory>
+#include <string>
+
+namespace rx::codegen {
+
+struct BackendOptions {
+  // 0 to 3, as -O of opt and llc
+  unsigned OptLevel = 2;
+  // Number of modules emitObjectArchive splits the program into, each
+  // optimized and compiled on a thread of its own
+  unsigned Partitions = 1;
+};
+
+llvm::CodeGenOpt::Level getCodeGenOptLevel(const BackendOptions &Opts);
+
+// Creates the target machine of the host. Returns nullptr and sets Error if
+// the native target is not available.
+std::unique_ptr<llvm::TargetMachine>
+createHostTargetMachine(const BackendOptions &Opts, std::string &Error);
+
+// Runs HeapMapPass and the default O<n> pipeline.
+void runOptimizationPipeline(llvm::Module &M, llvm::TargetMachine &TM,
+                             const BackendOptions &Opts);
+
+// Lowers gc pointers: place-safepoints inserts the polls and
+// rewrite-statepoints-for-gc turns every call into a statepoint. Runs
+// mem2reg first at O0, statepoints only relocate SSA values.
+void lowerGCPointers(llvm::Module &M, const BackendOptions &Opts);
+
+// Both of the above. This is the in-process replacement of
+// `opt -passes=...` in runtime/test.sh.
+void optimizeModule(llvm::Module &M, llvm::TargetMachine &TM,
+                    const BackendOptions &Opts);
+
+// Emits the object file of a lowered module. If it has statepoints, the
+// address of its stack map section is added to the rx_stackmaps table the
+// runtime's main registers. Returns false and sets Error if the target cannot
+// emit object files.
+bool emitObjectFile(llvm::Module &M, llvm::TargetMachine &TM,
+                    llvm::raw_pwrite_stream &OS, std::string &Error);
+
+// Splits the unoptimized module M with SplitModule into Opts.Partitions
+// modules, runs optimizeModule and emitObjectFile on each of them on a thread
+// pool and writes the objects as a static archive. Functions are no longer
+// inlined across partitions. M is left in an unspecified state. Returns false
+// and sets Error if any partition fails.
+bool emitObjectArchive(llvm::Module &M, const BackendOptions &Opts,
+                       llvm::raw_pwrite_stream &OS, std::string &Error);
+
+} // namespace rx::codegen
+
+#endif
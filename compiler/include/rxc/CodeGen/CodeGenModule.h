@@ -0,0 +1,169 @@
+#ifndef RXC_CODEGEN_CODEGENMODULE_H
+#define RXC_CODEGEN_CODEGENMODULE_H
+
+#include "rxc/AST/AST.h"
+#include "rxc/AST/QualType.h"
+#include "rxc/AST/TypeContext.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+
+namespace rx {
+
+class DiagnosticConsumer;
+
+namespace sema {
+class LexicalContext;
+}
+
+namespace codegen {
+
+// Address space of references into the gc heap, see runtime/gc.h.
+constexpr unsigned GCAddressSpace = 1;
+constexpr llvm::StringLiteral GCStrategy = "statepoint-example";
+
+// Lowers the type checked programs of all translation units into a single
+// llvm::Module. Programs are added in the order their globals must be
+// initialized in, i.e. imports first. Functions get the statepoint gc
+// strategy; the module still needs the gc lowering of the backend before
+// object code can be emitted.
+class CodeGenModule {
+public:
+  CodeGenModule(llvm::LLVMContext &Ctx, llvm::StringRef ModuleName,
+                const llvm::DataLayout &DL, llvm::StringRef Triple,
+                DiagnosticConsumer &DC, sema::LexicalContext &LC,
+                TypeContext &TC);
+
+  CodeGenModule(const CodeGenModule &) = delete;
+  CodeGenModule &operator=(const CodeGenModule &) = delete;
+
+public:
+  void addProgram(ast::ProgramDecl *Program);
+
+  // Emits every added program and the `program_entry` the runtime starts,
+  // which runs the global initializers and then `main` of Root. Returns
+  // nullptr if a diagnostic error was emitted.
+  std::unique_ptr<llvm::Module> generate(ast::ProgramDecl *Root);
+
+  llvm::LLVMContext &getContext() const { return Ctx; }
+  llvm::Module &getModule() const { return *M; }
+  DiagnosticConsumer &getDiagnostics() const { return DC; }
+  sema::LexicalContext &getLexicalContext() const { return LC; }
+  TypeContext &getTypeContext() const { return TC; }
+
+  // Lowers a rx type to its IR type. Unit lowers to void, value types to a
+  // struct of their fields in layout order and every heap allocated type to
+  // a gc pointer. Returns nullptr and emits an error at Loc for types
+  // without a representation yet.
+  llvm::Type *lowerType(QualType Ty, SourceLocation Loc);
+  // The type in which values of Ty are passed to and returned from calls.
+  // Value types are coerced to their eightbytes as the SysV ABI classifies
+  // them, other types cross calls as lowerType lowers them.
+  llvm::Type *lowerABIType(QualType Ty, SourceLocation Loc);
+  llvm::FunctionType *lowerFuncType(const FuncType *Ty, SourceLocation Loc);
+  llvm::Type *lowerEnumType(const EnumLayout &Layout);
+
+  // Layout of the object type Ty is or is defined as. Returns nullptr and
+  // emits an error at Loc for other types and objects without a layout.
+  const ObjectLayout *getObjectLayout(QualType Ty, SourceLocation Loc);
+  // Layout of Ty if it is a value type, see TypeContext::isValueType.
+  const ObjectLayout *getValueLayout(QualType Ty);
+
+  // Allocates a zeroed object of the layout in the gc heap. Objects with gc
+  // pointers are allocated with the type id of their heap map, which
+  // program_entry registers before anything else runs.
+  llvm::Value *emitAllocation(llvm::IRBuilderBase &Builder,
+                              const ObjectLayout &Layout);
+
+  // Stores V to the field of Obj, with the write barrier for gc pointers.
+  void emitFieldStore(llvm::IRBuilderBase &Builder, llvm::Value *Obj,
+                      const FieldLayout &Field, llvm::Value *V);
+  llvm::Value *emitFieldLoad(llvm::IRBuilderBase &Builder, llvm::Value *Obj,
+                             const FieldLayout &Field, llvm::Type *Ty);
+
+  // A value type stored into the heap, or whose address is taken, is copied
+  // to a box with the layout of the object type.
+  llvm::Value *emitBox(llvm::IRBuilderBase &Builder, const ObjectLayout &Layout,
+                       llvm::Value *V);
+  llvm::Value *emitUnbox(llvm::IRBuilderBase &Builder, llvm::Value *Box,
+                         llvm::Type *Ty);
+
+  // Strings, see runtime/string_object.h. A literal is emitted once for
+  // equal values, as an object in read-only data that is never allocated.
+  llvm::Constant *emitStringLiteral(llvm::StringRef Value);
+  llvm::Value *emitStringConcat(llvm::IRBuilderBase &Builder, llvm::Value *L,
+                                llvm::Value *R);
+  llvm::Value *emitStringEqual(llvm::IRBuilderBase &Builder, llvm::Value *L,
+                               llvm::Value *R);
+  // <0, 0 or >0 as an i32, ordering by the bytes
+  llvm::Value *emitStringCompare(llvm::IRBuilderBase &Builder, llvm::Value *L,
+                                 llvm::Value *R);
+
+  llvm::Function *getFunction(ast::FuncDecl *Decl) const {
+    return Functions.lookup(Decl);
+  }
+  llvm::GlobalVariable *getGlobal(ast::VarDecl *Decl) const {
+    return Globals.lookup(Decl);
+  }
+
+  void declareFunction(ast::FuncDecl *Decl, ast::ProgramDecl *Program,
+                       ast::ImplDecl *Impl, bool Exported);
+  void declareGlobal(ast::VarDecl *Decl, ast::ProgramDecl *Program,
+                     bool Exported);
+
+  // The IR constant of a value folded by type checking.
+  llvm::Constant *emitConstant(const ConstantValue &V);
+  // The value of a global initializer that needs no code to compute: a
+  // folded scalar or a literal of a value type with folded fields. Returns
+  // nullptr for other initializers.
+  llvm::Constant *emitConstantInitializer(ast::Expression *E, llvm::Type *Ty);
+
+  // Creates the function initializing the globals of Program that are not
+  // constants. program_entry calls them in the order they were created.
+  llvm::Function *createInitFunction(ast::ProgramDecl *Program);
+
+  void error(SourceLocation Loc, const llvm::Twine &Message);
+  bool hasErrors() const { return Errors; }
+
+private:
+  std::string mangle(ast::Decl *Decl, ast::ProgramDecl *Program,
+                     ast::ImplDecl *Impl) const;
+  llvm::FunctionCallee getRuntimeFunction(llvm::StringRef Name,
+                                          llvm::FunctionType *Ty,
+                                          bool GCLeaf = false);
+  llvm::GlobalVariable *getTypeId(const ObjectLayout &Layout);
+  void emitEntryPoint(ast::ProgramDecl *Root);
+
+private:
+  llvm::LLVMContext &Ctx;
+  std::unique_ptr<llvm::Module> M;
+  DiagnosticConsumer &DC;
+  sema::LexicalContext &LC;
+  TypeContext &TC;
+  bool Errors = false;
+
+  llvm::SmallVector<ast::ProgramDecl *, 8> Programs;
+  llvm::DenseMap<ast::FuncDecl *, llvm::Function *> Functions;
+  llvm::DenseMap<ast::VarDecl *, llvm::GlobalVariable *> Globals;
+  llvm::SmallVector<llvm::Function *, 8> InitFunctions;
+  // addresses of the gc pointers in mutable globals, which program_entry
+  // registers as roots
+  llvm::SmallVector<llvm::Constant *, 8> GlobalRoots;
+  // literals by their value
+  llvm::StringMap<llvm::GlobalVariable *> StringLiterals;
+  // type ids of the layouts with gc pointers
+  llvm::DenseMap<const ObjectLayout *, llvm::GlobalVariable *> TypeIds;
+  // (type id, heap map) in the order program_entry registers them
+  llvm::SmallVector<std::pair<llvm::GlobalVariable *, llvm::GlobalVariable *>, 8>
+      HeapMaps;
+};
+
+} // namespace codegen
+} // namespace rx
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef RXC_CODEGEN_JIT_H
+#define RXC_CODEGEN_JIT_H
+
+#include "rxc/CodeGen/Backend.h"
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+
+namespace rx::codegen {
+
+// Runs `program_entry` of a module from CodeGenModule in-process, on the
+// runtime linked into the frontend, and returns its exit code. The module
+// is optimized as a whole, then every function is lowered for the gc and
+// compiled on its first call through a lazy reexport. The stack maps of the
+// objects linked this way are registered with gc::statepoints.
+llvm::Expected<int> runInJIT(llvm::orc::ThreadSafeModule TSM,
+                             const BackendOptions &Opts);
+
+} // namespace rx::codegen
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SEMA_CONSTANT_EVALUATOR_H
+#define SEMA_CONSTANT_EVALUATOR_H
+
+#include "rxc/AST/AST.h"
+#include "rxc/AST/ConstantValue.h"
+#include <optional>
+
+namespace rx::sema {
+
+// Evaluates type checked expressions of builtin scalar types at compile
+// time: literals, arithmetic, comparisons and negation. Operands are not
+// evaluated again but read from the values type checking stored on them, so
+// folding an expression bottom up is linear in its size. Values wrap and
+// compare like the instructions codegen emits for them.
+class ConstantEvaluator {
+public:
+  // Returns std::nullopt if E is not constant, or if its value is not
+  // defined, as for a division by zero, which is left to the program.
+  static std::optional<ConstantValue> evaluate(ast::Expression *E);
+};
+
+} // namespace rx::sema
+
+#endif
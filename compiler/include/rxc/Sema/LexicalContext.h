@@ -6,7 +6,6 @@
 #include <deque>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/Support/raw_ostream.h>
-#include <unordered_map>
 
 namespace rx::sema {
 
@@ -34,14 +33,10 @@ public:
     for (const auto &Scope : ScopeStorage) {
       Scope.debug(OS);
     }
-    for (const auto& [Key, Value] : TypeImpls) {
-      OS << "TypeImpl: " << Key << " " << Value << "\n";
-    }
   }
 
 private:
   std::deque<LexicalScope> ScopeStorage;
-  std::unordered_multimap<ast::TypeDecl *, ast::FuncDecl *> TypeImpls;
 };
 
 } // namespace rx::sema
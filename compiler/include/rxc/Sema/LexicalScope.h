@@ -3,12 +3,17 @@
 
 #include "rxc/AST/AST.h"
 #include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/ErrorHandling.h>
 #include <llvm/Support/raw_ostream.h>
 
+namespace rx {
+class FuncType;
+}
+
 namespace rx::sema {
 
 class LexicalScope {
@@ -34,6 +39,13 @@ public:
   LexicalScope *parent() const { return Parent; }
   void insert(llvm::StringRef Symbol, ast::Decl *D);
 
+  // Functions declared in this scope by name and signature, see
+  // TypeContext::getSignature.
+  ast::FuncDecl *getOverload(llvm::StringRef Symbol,
+                             const FuncType *Signature) const;
+  void insertOverload(llvm::StringRef Symbol, const FuncType *Signature,
+                      ast::FuncDecl *F);
+
   void debug(llvm::raw_ostream &OS) const;
 
 private:
@@ -43,6 +55,8 @@ private:
   LexicalScope *Parent;
   Kind Type;
   llvm::StringMap<llvm::SmallVector<ast::Decl *, 4>> SymbolTable;
+  llvm::StringMap<llvm::DenseMap<const FuncType *, ast::FuncDecl *>>
+      Overloads;
 };
 } // namespace rx::sema
 
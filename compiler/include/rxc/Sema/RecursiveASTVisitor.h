@@ -156,7 +156,8 @@ protected:
   virtual T visit(ast::ASTEnumType *Node, sema::LexicalScope *LS) {
     T Last;
     for (auto &M : Node->getMembers())
-      Last = Visit(M.second);
+      if (M.second)
+        Last = Visit(M.second);
     return Last;
   }
 
@@ -224,6 +225,8 @@ protected:
     return Last;
   }
   virtual T visit(ast::ReturnStmt *Node, sema::LexicalScope *LS) {
+    if (!Node->getExpr())
+      return DefaultResult;
     return Visit(Node->getExpr());
   }
   virtual T visit(ast::DeclStmt *Node, sema::LexicalScope *LS) {
@@ -236,7 +239,7 @@ protected:
     if (Node->getPreHeader())
       Visit(Node->getPreHeader());
     if (Node->getCondition())
-      Visit(Node->getPostExpr());
+      Visit(Node->getCondition());
     if (Node->getPostExpr())
       Visit(Node->getPostExpr());
     return Visit(Node->getBody());
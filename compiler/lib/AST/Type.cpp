@@ -7,6 +7,19 @@ namespace rx {
 
 std::string rx::NamedType::getTypeName() const { return Decl->getName().str(); }
 
+llvm::ArrayRef<ast::FuncDecl *>
+NamedType::getMethods(llvm::StringRef Name) const {
+  auto It = Methods.find(Name);
+  if (It == Methods.end())
+    return {};
+  return It->second;
+}
+
+void NamedType::addImpl(ast::FuncDecl *Func) {
+  Impls.push_back(Func);
+  Methods[Func->getName()].push_back(Func);
+}
+
 std::string BuiltinType::getTypeName() const {
   switch (Ty) {
   case NativeType::i1:
@@ -34,11 +47,12 @@ std::string BuiltinType::getTypeName() const {
 
 namespace llvm {
 
+// The iteration order of a StringMap depends on its insertion history, so
+// the entries are combined independently of their order.
 hash_code hash_value(const llvm::StringMap<rx::QualType> &Val) {
-  hash_code Hash;
+  size_t Hash = Val.size();
   for (const auto &[Key, Value] : Val)
-    Hash = llvm::hash_combine(Hash, llvm::hash_value(Key),
-                              llvm::hash_value(Value));
+    Hash += llvm::hash_combine(llvm::hash_value(Key), llvm::hash_value(Value));
   return Hash;
 }
 
@@ -66,6 +66,14 @@ QualType TypeContext::getFuncType(llvm::ArrayRef<QualType> ParamTys,
   return &*It;
 }
 
+const FuncType *TypeContext::getSignature(llvm::ArrayRef<QualType> ParamTys) {
+  llvm::SmallVector<QualType, 8> Unqualified;
+  for (QualType P : ParamTys)
+    Unqualified.push_back(P.getType());
+  return static_cast<const FuncType *>(
+      getFuncType(Unqualified, getUnitType()).getType());
+}
+
 QualType TypeContext::getObjectType(llvm::StringMap<QualType> &&Fields) {
   ObjectType Key(std::move(Fields));
   auto [It, _] = ObjCtx.insert(std::move(Key));
@@ -83,4 +91,32 @@ void TypeContext::addImpl(ast::TypeDecl *Decl, ast::FuncDecl *Func) {
   NamedCtx[Decl]->addImpl(Func);
 }
 
+const ObjectLayout *TypeContext::getObjectLayout(const ObjectType *Ty) {
+  auto [It, Inserted] = LayoutCtx.try_emplace(Ty);
+  if (Inserted) {
+    if (auto Layout = ObjectLayout::compute(*Ty))
+      It->second = std::make_unique<ObjectLayout>(std::move(*Layout));
+  }
+  return It->second.get();
+}
+
+const EnumLayout *TypeContext::getEnumLayout(const EnumType *Ty) {
+  auto [It, Inserted] = EnumLayoutCtx.try_emplace(Ty);
+  if (Inserted) {
+    if (auto Layout = EnumLayout::compute(*Ty))
+      It->second = std::make_unique<EnumLayout>(std::move(*Layout));
+  }
+  return It->second.get();
+}
+
+bool TypeContext::isValueType(const ObjectType *Ty) {
+  // the largest aggregate the SysV ABI passes in registers
+  constexpr uint64_t MaxValueTypeSize = 16;
+  if (MutatedObjects.contains(Ty))
+    return false;
+  const ObjectLayout *Layout = getObjectLayout(Ty);
+  return Layout && !Layout->getNumGCPointers() &&
+         Layout->getSize() <= MaxValueTypeSize;
+}
+
 } // namespace rx
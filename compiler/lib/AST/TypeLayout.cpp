@@ -0,0 +1,157 @@
+#include "rxc/AST/TypeLayout.h"
+#include "rxc/AST/AST.h"
+#include "rxc/AST/Type.h"
+
+#include <algorithm>
+#include <llvm/Support/MathExtras.h>
+
+namespace rx {
+
+std::optional<StorageInfo> getStorageInfo(QualType Ty) {
+  const Type *T = Ty.getType();
+  if (const auto *BT = dynamic_cast<const BuiltinType *>(T)) {
+    switch (BT->getNativeType()) {
+    case NativeType::i1:
+    case NativeType::i8:
+      return StorageInfo{1, 1, false};
+    case NativeType::i16:
+      return StorageInfo{2, 2, false};
+    case NativeType::i32:
+    case NativeType::f32:
+      return StorageInfo{4, 4, false};
+    case NativeType::i64:
+    case NativeType::f64:
+      return StorageInfo{8, 8, false};
+    case NativeType::string:
+      return StorageInfo{8, 8, true};
+    }
+  }
+
+  if (const auto *Named = dynamic_cast<const NamedType *>(T))
+    return getStorageInfo(Named->getDecl()->getDeclaredType()->getType());
+
+  if (const auto *Enum = dynamic_cast<const EnumType *>(T)) {
+    if (auto Layout = EnumLayout::compute(*Enum))
+      return Layout->getStorage();
+    return std::nullopt;
+  }
+
+  // objects, arrays and the targets of pointers live in the gc heap
+  if (dynamic_cast<const ObjectType *>(T) || dynamic_cast<const ArrayType *>(T) ||
+      dynamic_cast<const PointerType *>(T))
+    return StorageInfo{8, 8, true};
+
+  return std::nullopt;
+}
+
+std::optional<ObjectLayout> ObjectLayout::compute(const ObjectType &Ty) {
+  ObjectLayout Layout;
+  for (const auto &[Name, FieldTy] : Ty.getFields()) {
+    auto Info = getStorageInfo(FieldTy);
+    if (!Info)
+      return std::nullopt;
+    Layout.Fields.push_back(
+        {Name, FieldTy, 0, Info->Size, Info->Align, Info->IsGCPointer});
+  }
+
+  std::sort(Layout.Fields.begin(), Layout.Fields.end(),
+            [](const FieldLayout &L, const FieldLayout &R) {
+              if (L.IsGCPointer != R.IsGCPointer)
+                return L.IsGCPointer;
+              if (L.Align != R.Align)
+                return L.Align > R.Align;
+              return L.Name < R.Name;
+            });
+
+  for (auto &Field : Layout.Fields) {
+    Field.Offset = llvm::alignTo(Layout.Size, Field.Align);
+    Layout.Size = Field.Offset + Field.Size;
+    Layout.Align = std::max(Layout.Align, Field.Align);
+    Layout.NumGCPointers += Field.IsGCPointer;
+  }
+  Layout.Size = llvm::alignTo(Layout.Size, Layout.Align);
+  return Layout;
+}
+
+const FieldLayout *ObjectLayout::getField(llvm::StringRef Name) const {
+  auto It = llvm::find_if(
+      Fields, [&](const FieldLayout &Field) { return Field.Name == Name; });
+  return It == Fields.end() ? nullptr : &*It;
+}
+
+std::optional<EnumLayout> EnumLayout::compute(const EnumType &Ty) {
+  EnumLayout Layout;
+  uint64_t ScalarSize = 0;
+  uint64_t ScalarAlign = 1;
+  unsigned NumPayloads = 0;
+  unsigned NumGCPointers = 0;
+  for (const auto &[Name, Payload] : Ty.getMembers()) {
+    bool IsGCPointer = false;
+    if (!dynamic_cast<const UnitType *>(Payload.getType())) {
+      auto Info = getStorageInfo(Payload);
+      if (!Info)
+        return std::nullopt;
+      ++NumPayloads;
+      IsGCPointer = Info->IsGCPointer;
+      NumGCPointers += IsGCPointer;
+      if (!IsGCPointer) {
+        ScalarSize = std::max(ScalarSize, Info->Size);
+        ScalarAlign = std::max(ScalarAlign, Info->Align);
+      }
+    }
+    Layout.Members.push_back({Name, Payload, 0, IsGCPointer});
+  }
+
+  std::sort(Layout.Members.begin(), Layout.Members.end(),
+            [](const Member &L, const Member &R) { return L.Name < R.Name; });
+  for (auto [Idx, M] : llvm::enumerate(Layout.Members))
+    M.Tag = Idx;
+
+  size_t NumMembers = Layout.Members.size();
+  Layout.TagSize = NumMembers <= (1u << 8) ? 1 : NumMembers <= (1u << 16) ? 2 : 4;
+
+  if (!NumPayloads) {
+    Layout.K = Kind::Tag;
+    Layout.DataSize = Layout.DataAlign = Layout.TagSize;
+    return Layout;
+  }
+  if (NumMembers == 2 && NumPayloads == 1 && NumGCPointers == 1) {
+    Layout.K = Kind::NullablePointer;
+    Layout.DataSize = Layout.DataAlign = 8;
+    return Layout;
+  }
+
+  Layout.K = NumGCPointers ? Kind::Boxed : Kind::Inline;
+  uint64_t GCSize = NumGCPointers ? 8 : 0;
+  Layout.ScalarOffset = llvm::alignTo(GCSize, ScalarAlign);
+  Layout.TagOffset =
+      llvm::alignTo(Layout.ScalarOffset + ScalarSize, Layout.TagSize);
+  Layout.DataAlign = std::max({GCSize, ScalarAlign, Layout.TagSize});
+  Layout.DataSize =
+      llvm::alignTo(Layout.TagOffset + Layout.TagSize, Layout.DataAlign);
+  return Layout;
+}
+
+StorageInfo EnumLayout::getStorage() const {
+  switch (K) {
+  case Kind::Tag:
+  case Kind::Inline:
+    return {DataSize, DataAlign, false};
+  case Kind::NullablePointer:
+  case Kind::Boxed:
+    return {8, 8, true};
+  }
+  llvm_unreachable("Unaccounted for enum layout kind");
+}
+
+const EnumLayout::Member *EnumLayout::getMember(llvm::StringRef Name) const {
+  auto It = llvm::find_if(Members,
+                          [&](const Member &M) { return M.Name == Name; });
+  return It == Members.end() ? nullptr : &*It;
+}
+
+uint64_t EnumLayout::getPayloadOffset(const Member &M) const {
+  return M.IsGCPointer ? 0 : ScalarOffset;
+}
+
+} // namespace rx
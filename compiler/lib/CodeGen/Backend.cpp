@@ -0,0 +1,232 @@
+#include "rxc/CodeGen/Backend.h"
+#include "HeapMapPass.h"
+
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/IPO/GlobalDCE.h>
+#include <llvm/Transforms/Scalar/PlaceSafepoints.h>
+#include <llvm/Transforms/Scalar/RewriteStatepointsForGC.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+using namespace llvm;
+
+namespace rx::codegen {
+
+namespace {
+
+OptimizationLevel getOptimizationLevel(unsigned Level) {
+  switch (Level) {
+  case 0:
+    return OptimizationLevel::O0;
+  case 1:
+    return OptimizationLevel::O1;
+  case 2:
+    return OptimizationLevel::O2;
+  default:
+    return OptimizationLevel::O3;
+  }
+}
+
+// place-safepoints inserts calls of gc.safepoint_poll and inlines them. The
+// function is private and unused until then, so it is only defined after
+// the optimization pipeline, whose global dce would remove it.
+class DefineSafepointPollPass : public PassInfoMixin<DefineSafepointPollPass> {
+public:
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) {
+    if (M.getFunction("gc.safepoint_poll"))
+      return PreservedAnalyses::all();
+
+    auto &Ctx = M.getContext();
+    auto *VoidFnTy = FunctionType::get(Type::getVoidTy(Ctx), false);
+    FunctionCallee RuntimePoll = M.getOrInsertFunction("runtime_gc_poll",
+                                                       VoidFnTy);
+    auto *Poll = Function::Create(VoidFnTy, GlobalValue::PrivateLinkage,
+                                  "gc.safepoint_poll", M);
+    IRBuilder<> Builder(BasicBlock::Create(Ctx, "entry", Poll));
+    Builder.CreateCall(RuntimePoll);
+    Builder.CreateRetVoid();
+
+    PreservedAnalyses PA;
+    PA.preserveSet<CFGAnalyses>();
+    return PA;
+  }
+};
+
+// Runs the passes added by Build with the analyses of the default pipeline.
+template <class BuildFn>
+void runModulePasses(Module &M, TargetMachine *TM, BuildFn Build) {
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  PassBuilder PB(TM);
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM;
+  Build(PB, MPM);
+  MPM.run(M, MAM);
+}
+
+bool hasStatepoints(const Module &M) {
+  return any_of(M, [](const Function &F) {
+    return F.getIntrinsicID() == Intrinsic::experimental_gc_statepoint &&
+           !F.use_empty();
+  });
+}
+
+} // namespace
+
+CodeGenOpt::Level getCodeGenOptLevel(const BackendOptions &Opts) {
+  switch (Opts.OptLevel) {
+  case 0:
+    return CodeGenOpt::None;
+  case 1:
+    return CodeGenOpt::Less;
+  case 2:
+    return CodeGenOpt::Default;
+  default:
+    return CodeGenOpt::Aggressive;
+  }
+}
+
+std::unique_ptr<TargetMachine>
+createHostTargetMachine(const BackendOptions &Opts, std::string &Error) {
+  std::string Triple = sys::getDefaultTargetTriple();
+  const Target *T = TargetRegistry::lookupTarget(Triple, Error);
+  if (!T)
+    return nullptr;
+
+  TargetOptions Options;
+  return std::unique_ptr<TargetMachine>(T->createTargetMachine(
+      Triple, "generic", "", Options, Reloc::PIC_, std::nullopt,
+      getCodeGenOptLevel(Opts)));
+}
+
+void runOptimizationPipeline(Module &M, TargetMachine &TM,
+                             const BackendOptions &Opts) {
+  runModulePasses(M, &TM, [&](PassBuilder &PB, ModulePassManager &MPM) {
+    MPM.addPass(HeapMapPass());
+    if (Opts.OptLevel == 0)
+      MPM.addPass(PB.buildO0DefaultPipeline(OptimizationLevel::O0));
+    else
+      MPM.addPass(PB.buildPerModuleDefaultPipeline(
+          getOptimizationLevel(Opts.OptLevel)));
+  });
+}
+
+void lowerGCPointers(Module &M, const BackendOptions &Opts) {
+  runModulePasses(M, nullptr, [&](PassBuilder &PB, ModulePassManager &MPM) {
+    if (Opts.OptLevel == 0)
+      MPM.addPass(createModuleToFunctionPassAdaptor(PromotePass()));
+    MPM.addPass(DefineSafepointPollPass());
+    MPM.addPass(createModuleToFunctionPassAdaptor(PlaceSafepointsPass()));
+    MPM.addPass(RewriteStatepointsForGC());
+  });
+}
+
+void optimizeModule(Module &M, TargetMachine &TM, const BackendOptions &Opts) {
+  runOptimizationPipeline(M, TM, Opts);
+  lowerGCPointers(M, Opts);
+  if (Opts.OptLevel > 0)
+    runModulePasses(M, &TM, [](PassBuilder &, ModulePassManager &MPM) {
+      MPM.addPass(GlobalDCEPass());
+    });
+}
+
+bool emitObjectFile(Module &M, TargetMachine &TM, raw_pwrite_stream &OS,
+                    std::string &Error) {
+  // __LLVM_StackMaps is local to the object, the runtime's main walks the
+  // rx_stackmaps table instead, one entry for every object with statepoints
+  if (hasStatepoints(M)) {
+    M.appendModuleInlineAsm(".pushsection rx_stackmaps,\"aw\",@progbits");
+    M.appendModuleInlineAsm(".p2align 3");
+    M.appendModuleInlineAsm(".quad __LLVM_StackMaps");
+    M.appendModuleInlineAsm(".popsection");
+  }
+
+  legacy::PassManager PM;
+  if (TM.addPassesToEmitFile(PM, OS, nullptr, CGFT_ObjectFile)) {
+    Error = "target '" + TM.getTargetTriple().str() +
+            "' cannot emit object files";
+    return false;
+  }
+  PM.run(M);
+  return true;
+}
+
+bool emitObjectArchive(Module &M, const BackendOptions &Opts,
+                       raw_pwrite_stream &OS, std::string &Error) {
+  // Modules cannot cross contexts, every partition is handed to its thread
+  // as bitcode and compiled in a context of its own.
+  std::vector<SmallString<0>> Parts;
+  SplitModule(M, Opts.Partitions, [&](std::unique_ptr<Module> Part) {
+    raw_svector_ostream BC(Parts.emplace_back());
+    WriteBitcodeToFile(*Part, BC);
+  });
+
+  std::vector<SmallString<0>> Objects(Parts.size());
+  std::vector<std::string> Errors(Parts.size());
+  ThreadPool Pool(hardware_concurrency(Opts.Partitions));
+  for (size_t I = 0; I < Parts.size(); ++I)
+    Pool.async([&, I] {
+      LLVMContext Ctx;
+      auto Part = parseBitcodeFile(MemoryBufferRef(Parts[I], M.getName()), Ctx);
+      if (!Part) {
+        Errors[I] = toString(Part.takeError());
+        return;
+      }
+      // target machines are not shareable between threads
+      auto TM = createHostTargetMachine(Opts, Errors[I]);
+      if (!TM)
+        return;
+      optimizeModule(**Part, *TM, Opts);
+      raw_svector_ostream Obj(Objects[I]);
+      emitObjectFile(**Part, *TM, Obj, Errors[I]);
+    });
+  Pool.wait();
+
+  std::vector<std::string> Names;
+  std::vector<NewArchiveMember> Members;
+  for (size_t I = 0; I < Parts.size(); ++I) {
+    if (!Errors[I].empty()) {
+      Error = std::move(Errors[I]);
+      return false;
+    }
+    Names.push_back(sys::path::stem(M.getName()).str() + "." +
+                    std::to_string(I) + ".o");
+  }
+  for (size_t I = 0; I < Parts.size(); ++I)
+    Members.emplace_back(MemoryBufferRef(Objects[I], Names[I]));
+
+  auto Archive = writeArchiveToBuffer(Members, /*WriteSymtab=*/true,
+                                      object::Archive::K_GNU,
+                                      /*Deterministic=*/true, /*Thin=*/false);
+  if (!Archive) {
+    Error = toString(Archive.takeError());
+    return false;
+  }
+  OS << (*Archive)->getBuffer();
+  return true;
+}
+
+} // namespace rx::codegen
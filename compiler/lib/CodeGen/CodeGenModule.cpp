@@ -0,0 +1,1189 @@
+#include "rxc/CodeGen/CodeGenModule.h"
+#include "rxc/AST/AST.h"
+#include "rxc/AST/Type.h"
+#include "rxc/Basic/Diagnostic.h"
+#include "rxc/Sema/LexicalContext.h"
+#include "rxc/Sema/LexicalScope.h"
+#include "rxc/Sema/RecursiveASTVisitor.h"
+
+#include "object_header.h"
+#include "string_object.h"
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstring>
+
+using namespace rx::ast;
+using namespace rx::sema;
+using namespace llvm;
+
+namespace rx::codegen {
+
+namespace {
+
+const FuncType *getFuncType(FuncDecl *F) {
+  return dynamic_cast<const FuncType *>(F->getDeclaredType()->getType().getType());
+}
+
+bool isUnit(QualType T) { return dynamic_cast<const UnitType *>(T.getType()); }
+
+bool isString(QualType T) {
+  const auto *BT = dynamic_cast<const BuiltinType *>(T.getType());
+  return BT && BT->getNativeType() == NativeType::string;
+}
+
+// Appends the offsets of the gc pointers in a value of type Ty at Offset.
+void collectGCPointers(llvm::Type *Ty, uint64_t Offset, const DataLayout &DL,
+                       SmallVectorImpl<uint64_t> &Offsets) {
+  if (auto *PT = dyn_cast<llvm::PointerType>(Ty)) {
+    if (PT->getAddressSpace() == GCAddressSpace)
+      Offsets.push_back(Offset);
+  } else if (auto *ST = dyn_cast<llvm::StructType>(Ty)) {
+    const StructLayout *SL = DL.getStructLayout(ST);
+    for (unsigned I = 0; I < ST->getNumElements(); ++I)
+      collectGCPointers(ST->getElementType(I),
+                        Offset + SL->getElementOffset(I), DL, Offsets);
+  } else if (auto *AT = dyn_cast<llvm::ArrayType>(Ty)) {
+    uint64_t Size = DL.getTypeAllocSize(AT->getElementType());
+    for (uint64_t I = 0; I < AT->getNumElements(); ++I)
+      collectGCPointers(AT->getElementType(), Offset + I * Size, DL, Offsets);
+  }
+}
+
+// Declares every function and global of a program, so that bodies can refer
+// to declarations of any translation unit regardless of their order.
+class DeclareSymbols final : public RecursiveASTVisitor<> {
+public:
+  DeclareSymbols(CodeGenModule &CGM, ProgramDecl *Program)
+      : RecursiveASTVisitor<>(CGM.getLexicalContext()), CGM(CGM),
+        Program(Program) {}
+
+  void start() { Visit(Program); }
+
+private:
+  ResultType visit(ExportedDecl *Node, LexicalScope *LS) override {
+    Exported = Node->getVisibility() == Visibility::Public;
+    return Visit(Node->getExportedDecl());
+  }
+
+  ResultType visit(ImplDecl *Node, LexicalScope *LS) override {
+    Impl = Node;
+    for (auto *F : Node->getImpls())
+      Visit(F);
+    Impl = nullptr;
+    return {};
+  }
+
+  ResultType visit(FuncDecl *Node, LexicalScope *LS) override {
+    CGM.declareFunction(Node, Program, Impl, Exported);
+    return {};
+  }
+
+  ResultType visit(VarDecl *Node, LexicalScope *LS) override {
+    CGM.declareGlobal(Node, Program, Exported);
+    return {};
+  }
+
+  ResultType visit(TypeDecl *Node, LexicalScope *LS) override { return {}; }
+  ResultType visit(UseDecl *Node, LexicalScope *LS) override { return {}; }
+
+private:
+  CodeGenModule &CGM;
+  ProgramDecl *Program;
+  ImplDecl *Impl = nullptr;
+  bool Exported = false;
+};
+
+// Emits the bodies of the functions of a program and the initializers of
+// its globals that are not constants. Expressions evaluate to their value,
+// or to nullptr for unit.
+class EmitProgram final : public RecursiveASTVisitor<Value *> {
+public:
+  EmitProgram(CodeGenModule &CGM, ProgramDecl *Program)
+      : RecursiveASTVisitor<Value *>(CGM.getLexicalContext(), nullptr),
+        CGM(CGM), Program(Program), Builder(CGM.getContext()) {}
+
+  void start() {
+    Visit(Program);
+    if (InitFn) {
+      Builder.SetInsertPoint(InitTail);
+      Builder.CreateRetVoid();
+    }
+  }
+
+private:
+  Value *unsupported(ASTNode *Node, StringRef What) {
+    CGM.error(Node->Loc, What + " is not supported by codegen yet");
+    return nullptr;
+  }
+
+  llvm::Type *lower(QualType T, ASTNode *Node) {
+    return CGM.lowerType(T, Node->Loc);
+  }
+
+  // Allocas go to the entry block so that mem2reg can promote them.
+  AllocaInst *createLocal(llvm::Type *Ty, StringRef Name) {
+    BasicBlock &Entry = CurFn->getEntryBlock();
+    IRBuilder<> EntryBuilder(&Entry, Entry.begin());
+    return EntryBuilder.CreateAlloca(Ty, nullptr, Name);
+  }
+
+  void startBlock(BasicBlock *BB) {
+    BB->insertInto(CurFn);
+    Builder.SetInsertPoint(BB);
+  }
+
+  // Code after a return is unreachable, it goes to a block of its own
+  // without predecessors.
+  void startDeadBlock() {
+    startBlock(BasicBlock::Create(CGM.getContext(), "dead"));
+  }
+
+  // After an error the blocks of a branch are still emitted, the module is
+  // discarded anyway.
+  Value *emitCondition(Expression *E) {
+    Value *C = Visit(E);
+    return C ? C : PoisonValue::get(Builder.getInt1Ty());
+  }
+
+  Value *load(Decl *D, SourceLocation Loc) {
+    if (auto *Local = Locals.lookup(D))
+      return Builder.CreateLoad(Local->getAllocatedType(), Local, D->getName());
+    if (auto *Var = dynamic_cast<VarDecl *>(D)) {
+      if (auto *G = CGM.getGlobal(Var))
+        return Builder.CreateLoad(G->getValueType(), G, D->getName());
+    }
+    CGM.error(Loc, "'" + D->getName() + "' is not a value");
+    return nullptr;
+  }
+
+  // Value types cross calls in their ABI type, which is no larger than
+  // their struct; the conversion goes through memory and SROA folds it.
+  Value *coerce(Value *V, llvm::Type *To) {
+    if (V->getType() == To)
+      return V;
+    const DataLayout &DL = CGM.getModule().getDataLayout();
+    llvm::Type *Storage =
+        DL.getTypeAllocSize(To) > DL.getTypeAllocSize(V->getType())
+            ? To
+            : V->getType();
+    AllocaInst *Tmp = createLocal(Storage, "coerce");
+    Builder.CreateStore(V, Tmp);
+    return Builder.CreateLoad(To, Tmp);
+  }
+
+  // Value types are boxed where they are stored into the heap.
+  Value *boxIfValue(QualType Ty, Value *V) {
+    if (const ObjectLayout *Layout = CGM.getValueLayout(Ty))
+      return CGM.emitBox(Builder, *Layout, V);
+    return V;
+  }
+
+  Value *address(Decl *D) {
+    if (auto *Local = Locals.lookup(D))
+      return Local;
+    if (auto *Var = dynamic_cast<VarDecl *>(D))
+      return CGM.getGlobal(Var);
+    return nullptr;
+  }
+
+private:
+  Value *visit(TypeDecl *Node, LexicalScope *LS) override { return nullptr; }
+  Value *visit(UseDecl *Node, LexicalScope *LS) override { return nullptr; }
+
+  Value *visit(FuncDecl *Node, LexicalScope *LS) override {
+    Function *F = CGM.getFunction(Node);
+    if (!F)
+      return nullptr;
+    const FuncType *FT = getFuncType(Node);
+
+    CurFn = F;
+    ReturnType = FT->getReturnType();
+    Locals.clear();
+    startBlock(BasicBlock::Create(CGM.getContext(), "entry"));
+
+    // the slot of a value type takes the bits of its ABI type
+    for (auto [Param, Arg] : llvm::zip(Node->getParams(), F->args())) {
+      Arg.setName(Param->getName());
+      auto *Slot = createLocal(lower(Param->getType(), Param), Param->getName());
+      Builder.CreateStore(&Arg, Slot);
+      Locals[Param] = Slot;
+    }
+
+    Visit(Node->getBody());
+
+    BasicBlock *Tail = Builder.GetInsertBlock();
+    if (!Tail->getTerminator()) {
+      if (F->getReturnType()->isVoidTy())
+        Builder.CreateRetVoid();
+      else if (Tail != &F->getEntryBlock() && pred_empty(Tail))
+        Builder.CreateUnreachable();
+      else
+        CGM.error(Node->getDeclLoc(), "function '" + Node->getName() +
+                                          "' does not return a value on "
+                                          "every path");
+    }
+    CurFn = nullptr;
+    return nullptr;
+  }
+
+  Value *visit(VarDecl *Node, LexicalScope *LS) override {
+    if (!CurFn)
+      return emitGlobalInit(Node);
+
+    llvm::Type *Ty = lower(Node->getType(), Node);
+    if (!Ty)
+      return nullptr;
+    auto *Slot = createLocal(Ty, Node->getName());
+    Locals[Node] = Slot;
+
+    Value *Init = Node->getInitializer() ? Visit(Node->getInitializer())
+                                         : Constant::getNullValue(Ty);
+    if (Init)
+      Builder.CreateStore(Init, Slot);
+    return nullptr;
+  }
+
+  // Globals with a constant initializer are initialized when they are
+  // declared, the others by the init function of the program, which
+  // program_entry runs before main.
+  Value *emitGlobalInit(VarDecl *Node) {
+    GlobalVariable *G = CGM.getGlobal(Node);
+    if (!G || !Node->getInitializer() ||
+        CGM.emitConstantInitializer(Node->getInitializer(), G->getValueType()))
+      return nullptr;
+
+    if (!InitFn) {
+      InitFn = CGM.createInitFunction(Program);
+      InitTail = BasicBlock::Create(CGM.getContext(), "entry", InitFn);
+    }
+    CurFn = InitFn;
+    Builder.SetInsertPoint(InitTail);
+    if (Value *Init = Visit(Node->getInitializer()))
+      Builder.CreateStore(Init, G);
+    InitTail = Builder.GetInsertBlock();
+    CurFn = nullptr;
+    return nullptr;
+  }
+
+  // statements
+  Value *visit(ReturnStmt *Node, LexicalScope *LS) override {
+    if (!Node->getExpr() || isUnit(ReturnType)) {
+      if (Node->getExpr())
+        Visit(Node->getExpr());
+      Builder.CreateRetVoid();
+    } else if (Value *V = Visit(Node->getExpr())) {
+      Builder.CreateRet(coerce(V, CurFn->getReturnType()));
+    } else {
+      Builder.CreateUnreachable();
+    }
+    startDeadBlock();
+    return nullptr;
+  }
+
+  Value *visit(DeclStmt *Node, LexicalScope *LS) override {
+    return Visit(Node->getDecl());
+  }
+
+  Value *visit(ExprStmt *Node, LexicalScope *LS) override {
+    Visit(Node->getExpr());
+    return nullptr;
+  }
+
+  Value *visit(ForStmt *Node, LexicalScope *LS) override {
+    auto &Ctx = CGM.getContext();
+    if (Node->getPreHeader())
+      Visit(Node->getPreHeader());
+
+    auto *Cond = BasicBlock::Create(Ctx, "for.cond");
+    auto *Body = BasicBlock::Create(Ctx, "for.body");
+    auto *Exit = BasicBlock::Create(Ctx, "for.end");
+
+    Builder.CreateBr(Cond);
+    startBlock(Cond);
+    if (Node->getCondition()) {
+      Builder.CreateCondBr(emitCondition(Node->getCondition()), Body, Exit);
+    } else {
+      Builder.CreateBr(Body);
+    }
+
+    startBlock(Body);
+    Visit(Node->getBody());
+    if (Node->getPostExpr())
+      Visit(Node->getPostExpr());
+    Builder.CreateBr(Cond);
+
+    startBlock(Exit);
+    return nullptr;
+  }
+
+  // expressions
+  Value *visit(BoolLiteral *Node, LexicalScope *LS) override {
+    return Builder.getInt1(Node->getValue());
+  }
+
+  Value *visit(CharLiteral *Node, LexicalScope *LS) override {
+    return Builder.getInt8(Node->getValue());
+  }
+
+  Value *visit(NumLiteral *Node, LexicalScope *LS) override {
+    llvm::Type *Ty = lower(Node->getExprType(), Node);
+    const ConstantValue *V = Node->getConstantValue();
+    return Ty && V ? CGM.emitConstant(*V) : nullptr;
+  }
+
+  Value *visit(ast::StringLiteral *Node, LexicalScope *LS) override {
+    return CGM.emitStringLiteral(Node->getValue());
+  }
+
+  // Fields are evaluated in memory order before the allocation, so that no
+  // safepoint falls between it and the stores. Literals of value types
+  // allocate nothing.
+  Value *visit(ObjectLiteral *Node, LexicalScope *LS) override {
+    const ObjectLayout *Layout =
+        CGM.getObjectLayout(Node->getExprType(), Node->Loc);
+    if (!Layout)
+      return nullptr;
+    bool IsValue = CGM.getValueLayout(Node->getExprType());
+
+    SmallVector<Value *, 8> Values;
+    for (const FieldLayout &Field : Layout->getFields()) {
+      Value *V = Visit(Node->getFields().lookup(Field.Name));
+      if (!V)
+        return nullptr;
+      Values.push_back(IsValue ? V : boxIfValue(Field.Type, V));
+    }
+
+    if (IsValue) {
+      Value *Obj = PoisonValue::get(lower(Node->getExprType(), Node));
+      for (auto [Idx, V] : llvm::enumerate(Values))
+        Obj = Builder.CreateInsertValue(Obj, V, Idx);
+      return Obj;
+    }
+
+    Value *Obj = CGM.emitAllocation(Builder, *Layout);
+    for (auto [Field, V] : llvm::zip(Layout->getFields(), Values))
+      CGM.emitFieldStore(Builder, Obj, Field, V);
+    return Obj;
+  }
+
+  // The heap object and the layout of its field, or nullptr after an error.
+  // A pointer to an object is the address of its payload, see emitReference.
+  std::pair<Value *, const FieldLayout *> emitFieldAccess(AccessExpr *Node) {
+    QualType ObjTy = Node->getExpr()->getExprType();
+    if (const auto *Ptr = dynamic_cast<const rx::PointerType *>(ObjTy.getType()))
+      ObjTy = Ptr->getPointeeType();
+    const ObjectLayout *Layout = CGM.getObjectLayout(ObjTy, Node->Loc);
+    Value *Obj = Layout ? Visit(Node->getExpr()) : nullptr;
+    if (!Obj)
+      return {};
+    return {Obj, Layout->getField(Node->getAccessor())};
+  }
+
+  Value *visit(AccessExpr *Node, LexicalScope *LS) override {
+    llvm::Type *Ty = lower(Node->getExprType(), Node);
+    if (!Ty)
+      return nullptr;
+
+    if (const ObjectLayout *Layout =
+            CGM.getValueLayout(Node->getExpr()->getExprType())) {
+      Value *Obj = Visit(Node->getExpr());
+      if (!Obj)
+        return nullptr;
+      const FieldLayout *Field = Layout->getField(Node->getAccessor());
+      return Builder.CreateExtractValue(Obj, Field - Layout->getFields().begin(),
+                                        Field->Name);
+    }
+
+    auto [Obj, Field] = emitFieldAccess(Node);
+    if (!Obj)
+      return nullptr;
+    if (!CGM.getValueLayout(Field->Type))
+      return CGM.emitFieldLoad(Builder, Obj, *Field, Ty);
+    Value *Box = CGM.emitFieldLoad(
+        Builder, Obj, *Field,
+        llvm::PointerType::get(CGM.getContext(), GCAddressSpace));
+    return CGM.emitUnbox(Builder, Box, Ty);
+  }
+
+  Value *visit(IndexExpr *Node, LexicalScope *LS) override {
+    return unsupported(Node, "index expression");
+  }
+
+  Value *visit(DeclRefExpr *Node, LexicalScope *LS) override {
+    Decl *D = Node->getRefDecl();
+    if (!D)
+      return unsupported(Node, "unresolved reference");
+    if (dynamic_cast<FuncDecl *>(D))
+      return unsupported(Node, "function value");
+    return load(D, Node->Loc);
+  }
+
+  Value *visit(AssignExpr *Node, LexicalScope *LS) override {
+    if (auto *Access = dynamic_cast<AccessExpr *>(Node->getLHS())) {
+      auto [Obj, Field] = emitFieldAccess(Access);
+      Value *V = Obj ? Visit(Node->getRHS()) : nullptr;
+      if (V)
+        CGM.emitFieldStore(Builder, Obj, *Field, boxIfValue(Field->Type, V));
+      return V;
+    }
+
+    auto *Ref = dynamic_cast<DeclRefExpr *>(Node->getLHS());
+    Value *Addr = Ref && Ref->getRefDecl() ? address(Ref->getRefDecl()) : nullptr;
+    if (!Addr)
+      return unsupported(Node, "assignment to this expression");
+    Value *V = Visit(Node->getRHS());
+    if (V)
+      Builder.CreateStore(V, Addr);
+    return V;
+  }
+
+  // Objects are referenced by the address of their payload: a heap object
+  // is its own address and a value type is boxed.
+  Value *emitReference(Expression *E, ASTNode *Node) {
+    QualType Ty = E->getExprType();
+    if (const NamedType *Named = dynamic_cast<const NamedType *>(Ty.getType()))
+      Ty = Named->getDecl()->getDeclaredType()->getType();
+    if (!dynamic_cast<const ObjectType *>(Ty.getType()))
+      return unsupported(Node, "taking a reference");
+
+    Value *V = Visit(E);
+    if (const ObjectLayout *Layout = CGM.getValueLayout(Ty))
+      return V ? CGM.emitBox(Builder, *Layout, V) : nullptr;
+    return V;
+  }
+
+  // The value a pointer to an object of type Ty points to: a heap object is
+  // the pointer itself, a value type is loaded from its box.
+  Value *emitDereference(Value *Ptr, QualType Ty, ASTNode *Node) {
+    if (!CGM.getValueLayout(Ty))
+      return Ptr;
+    llvm::Type *ValueTy = lower(Ty, Node);
+    return ValueTy ? CGM.emitUnbox(Builder, Ptr, ValueTy) : nullptr;
+  }
+
+  // Methods are resolved statically, a method call is a direct call with
+  // the receiver as first argument.
+  Value *visit(CallExpr *Node, LexicalScope *LS) override {
+    FuncDecl *Decl = Node->getCalleeDecl();
+    Function *F = Decl ? CGM.getFunction(Decl) : nullptr;
+    if (!F)
+      return unsupported(Node, "call of this expression");
+
+    SmallVector<Value *, 8> Args;
+    ArrayRef<llvm::Type *> ParamTys = F->getFunctionType()->params();
+    if (auto *Method = dynamic_cast<AccessExpr *>(Node->getCallee())) {
+      Expression *Receiver = Method->getExpr();
+      QualType Self = getFuncType(Decl)->getParamTypes().front();
+      bool SelfIsPointer = dynamic_cast<const rx::PointerType *>(Self.getType());
+      bool ReceiverIsPointer = dynamic_cast<const rx::PointerType *>(
+          Receiver->getExprType().getType());
+      Value *V = SelfIsPointer && !ReceiverIsPointer
+                     ? emitReference(Receiver, Method)
+                     : Visit(Receiver);
+      if (V && !SelfIsPointer && ReceiverIsPointer)
+        V = emitDereference(V, Self, Method);
+      if (!V)
+        return nullptr;
+      Args.push_back(coerce(V, ParamTys.front()));
+      ParamTys = ParamTys.drop_front();
+    }
+    for (auto [Arg, ParamTy] : llvm::zip(Node->getArgs(), ParamTys)) {
+      Value *V = Visit(Arg);
+      if (!V)
+        return nullptr;
+      Args.push_back(coerce(V, ParamTy));
+    }
+    CallInst *Call = Builder.CreateCall(F, Args);
+    if (F->getReturnType()->isVoidTy())
+      return nullptr;
+    llvm::Type *Ty = lower(Node->getExprType(), Node);
+    return Ty ? coerce(Call, Ty) : nullptr;
+  }
+
+  // Expressions folded by type checking are emitted as their value.
+  Value *visit(BinaryExpr *Node, LexicalScope *LS) override {
+    if (const ConstantValue *V = Node->getConstantValue())
+      return CGM.emitConstant(*V);
+    Value *L = Visit(Node->getLHS());
+    Value *R = Visit(Node->getRHS());
+    if (!L || !R)
+      return nullptr;
+
+    if (isString(Node->getLHS()->getExprType()))
+      return emitStringOperator(Node, L, R);
+    if (L->getType()->isFloatingPointTy()) {
+      switch (Node->getOp()) {
+      case BinaryOp::Mult:
+        return Builder.CreateFMul(L, R);
+      case BinaryOp::Div:
+        return Builder.CreateFDiv(L, R);
+      case BinaryOp::Add:
+        return Builder.CreateFAdd(L, R);
+      case BinaryOp::Sub:
+        return Builder.CreateFSub(L, R);
+      case BinaryOp::Less:
+        return Builder.CreateFCmpOLT(L, R);
+      case BinaryOp::Greater:
+        return Builder.CreateFCmpOGT(L, R);
+      case BinaryOp::LessThanEqual:
+        return Builder.CreateFCmpOLE(L, R);
+      case BinaryOp::GreaterThanEqual:
+        return Builder.CreateFCmpOGE(L, R);
+      case BinaryOp::CmpEqual:
+        return Builder.CreateFCmpOEQ(L, R);
+      case BinaryOp::CmpNotEqual:
+        return Builder.CreateFCmpUNE(L, R);
+      case BinaryOp::Equal:
+        break;
+      }
+    } else {
+      switch (Node->getOp()) {
+      case BinaryOp::Mult:
+        return Builder.CreateMul(L, R);
+      case BinaryOp::Div:
+        return Builder.CreateSDiv(L, R);
+      case BinaryOp::Add:
+        return Builder.CreateAdd(L, R);
+      case BinaryOp::Sub:
+        return Builder.CreateSub(L, R);
+      case BinaryOp::Less:
+        return Builder.CreateICmpSLT(L, R);
+      case BinaryOp::Greater:
+        return Builder.CreateICmpSGT(L, R);
+      case BinaryOp::LessThanEqual:
+        return Builder.CreateICmpSLE(L, R);
+      case BinaryOp::GreaterThanEqual:
+        return Builder.CreateICmpSGE(L, R);
+      case BinaryOp::CmpEqual:
+        return Builder.CreateICmpEQ(L, R);
+      case BinaryOp::CmpNotEqual:
+        return Builder.CreateICmpNE(L, R);
+      case BinaryOp::Equal:
+        break;
+      }
+    }
+    return unsupported(Node, "binary operator");
+  }
+
+  Value *emitStringOperator(BinaryExpr *Node, Value *L, Value *R) {
+    switch (Node->getOp()) {
+    case BinaryOp::Add:
+      return CGM.emitStringConcat(Builder, L, R);
+    case BinaryOp::CmpEqual:
+      return CGM.emitStringEqual(Builder, L, R);
+    case BinaryOp::CmpNotEqual:
+      return Builder.CreateNot(CGM.emitStringEqual(Builder, L, R));
+    default:
+      break;
+    }
+
+    Value *Cmp = CGM.emitStringCompare(Builder, L, R);
+    Value *Zero = Builder.getInt32(0);
+    switch (Node->getOp()) {
+    case BinaryOp::Less:
+      return Builder.CreateICmpSLT(Cmp, Zero);
+    case BinaryOp::Greater:
+      return Builder.CreateICmpSGT(Cmp, Zero);
+    case BinaryOp::LessThanEqual:
+      return Builder.CreateICmpSLE(Cmp, Zero);
+    case BinaryOp::GreaterThanEqual:
+      return Builder.CreateICmpSGE(Cmp, Zero);
+    default:
+      return unsupported(Node, "binary operator");
+    }
+  }
+
+  Value *visit(UnaryExpr *Node, LexicalScope *LS) override {
+    if (Node->getOp() == UnaryOp::Ref)
+      return emitReference(Node->getExpr(), Node);
+    if (const ConstantValue *C = Node->getConstantValue())
+      return CGM.emitConstant(*C);
+    Value *V = Visit(Node->getExpr());
+    if (!V)
+      return nullptr;
+    if (Node->getOp() == UnaryOp::Not)
+      return Builder.CreateNot(V);
+    return V->getType()->isFloatingPointTy() ? Builder.CreateFNeg(V)
+                                             : Builder.CreateNeg(V);
+  }
+
+  Value *visit(IfExpr *Node, LexicalScope *LS) override {
+    // only the branch a constant condition takes is emitted
+    if (const ConstantValue *V = Node->getCondition()->getConstantValue()) {
+      if (BlockStmt *Taken = V->getBool() ? Node->getBody()
+                                          : Node->getElseBlock())
+        Visit(Taken);
+      return nullptr;
+    }
+
+    auto &Ctx = CGM.getContext();
+    Value *C = emitCondition(Node->getCondition());
+
+    auto *Then = BasicBlock::Create(Ctx, "if.then");
+    auto *Else = Node->getElseBlock() ? BasicBlock::Create(Ctx, "if.else")
+                                      : nullptr;
+    auto *End = BasicBlock::Create(Ctx, "if.end");
+    Builder.CreateCondBr(C, Then, Else ? Else : End);
+
+    startBlock(Then);
+    Visit(Node->getBody());
+    Builder.CreateBr(End);
+
+    if (Else) {
+      startBlock(Else);
+      Visit(Node->getElseBlock());
+      Builder.CreateBr(End);
+    }
+
+    startBlock(End);
+    return nullptr;
+  }
+
+private:
+  CodeGenModule &CGM;
+  ProgramDecl *Program;
+  IRBuilder<> Builder;
+
+  Function *CurFn = nullptr;
+  QualType ReturnType;
+  DenseMap<Decl *, AllocaInst *> Locals;
+
+  Function *InitFn = nullptr;
+  BasicBlock *InitTail = nullptr;
+};
+
+} // namespace
+
+CodeGenModule::CodeGenModule(LLVMContext &Ctx, StringRef ModuleName,
+                             const DataLayout &DL, StringRef Triple,
+                             DiagnosticConsumer &DC, LexicalContext &LC,
+                             TypeContext &TC)
+    : Ctx(Ctx), M(std::make_unique<Module>(ModuleName, Ctx)), DC(DC), LC(LC),
+      TC(TC) {
+  M->setDataLayout(DL);
+  M->setTargetTriple(Triple);
+}
+
+void CodeGenModule::error(SourceLocation Loc, const Twine &Message) {
+  Diagnostic Err(Diagnostic::Type::Error, Message.str());
+  Err.setSourceLocation(Loc);
+  DC.emit(std::move(Err));
+  Errors = true;
+}
+
+llvm::Type *CodeGenModule::lowerType(QualType Ty, SourceLocation Loc) {
+  const rx::Type *T = Ty.getType();
+  if (!T) {
+    error(Loc, "cannot generate code for a value of unknown type");
+    return nullptr;
+  }
+  if (dynamic_cast<const UnitType *>(T))
+    return llvm::Type::getVoidTy(Ctx);
+
+  if (const auto *BT = dynamic_cast<const BuiltinType *>(T)) {
+    switch (BT->getNativeType()) {
+    case NativeType::i1:
+      return llvm::Type::getInt1Ty(Ctx);
+    case NativeType::i8:
+      return llvm::Type::getInt8Ty(Ctx);
+    case NativeType::i16:
+      return llvm::Type::getInt16Ty(Ctx);
+    case NativeType::i32:
+      return llvm::Type::getInt32Ty(Ctx);
+    case NativeType::i64:
+      return llvm::Type::getInt64Ty(Ctx);
+    case NativeType::f32:
+      return llvm::Type::getFloatTy(Ctx);
+    case NativeType::f64:
+      return llvm::Type::getDoubleTy(Ctx);
+    case NativeType::string:
+      return llvm::PointerType::get(Ctx, GCAddressSpace);
+    }
+  }
+
+  if (const auto *Named = dynamic_cast<const NamedType *>(T))
+    return lowerType(Named->getDecl()->getDeclaredType()->getType(), Loc);
+
+  if (const auto *Enum = dynamic_cast<const EnumType *>(T)) {
+    if (const EnumLayout *Layout = TC.getEnumLayout(Enum))
+      return lowerEnumType(*Layout);
+  }
+
+  if (const ObjectLayout *Layout = getValueLayout(T)) {
+    SmallVector<llvm::Type *, 4> Fields;
+    for (const FieldLayout &Field : Layout->getFields())
+      Fields.push_back(lowerType(Field.Type, Loc));
+    return StructType::get(Ctx, Fields);
+  }
+
+  // objects, arrays and the targets of pointers live in the gc heap
+  if (dynamic_cast<const ObjectType *>(T) || dynamic_cast<const ArrayType *>(T) ||
+      dynamic_cast<const rx::PointerType *>(T))
+    return llvm::PointerType::get(Ctx, GCAddressSpace);
+
+  error(Loc, "cannot generate code for a value of type '" + Ty.getTypeName() +
+                 "' yet");
+  return nullptr;
+}
+
+const ObjectLayout *CodeGenModule::getObjectLayout(QualType Ty,
+                                                  SourceLocation Loc) {
+  const rx::Type *T = Ty.getType();
+  if (const auto *Named = dynamic_cast<const NamedType *>(T))
+    T = Named->getDecl()->getDeclaredType()->getType().getType();
+
+  const auto *Obj = dynamic_cast<const ObjectType *>(T);
+  const ObjectLayout *Layout = Obj ? TC.getObjectLayout(Obj) : nullptr;
+  if (!Layout)
+    error(Loc, "cannot generate code for the fields of '" + Ty.getTypeName() +
+                   "' yet");
+  return Layout;
+}
+
+const ObjectLayout *CodeGenModule::getValueLayout(QualType Ty) {
+  const rx::Type *T = Ty.getType();
+  if (const auto *Named = dynamic_cast<const NamedType *>(T))
+    T = Named->getDecl()->getDeclaredType()->getType().getType();
+
+  const auto *Obj = dynamic_cast<const ObjectType *>(T);
+  return Obj && TC.isValueType(Obj) ? TC.getObjectLayout(Obj) : nullptr;
+}
+
+// An eightbyte of only floating point fields goes in an xmm register, any
+// other in a general purpose one. The ABI type has one element per
+// eightbyte, so that the backend assigns the registers the same way: two
+// doubles stay {double, double}, two floats become <2 x float> and two i32
+// an i64.
+llvm::Type *CodeGenModule::lowerABIType(QualType Ty, SourceLocation Loc) {
+  const ObjectLayout *Layout = getValueLayout(Ty);
+  llvm::Type *Lowered = lowerType(Ty, Loc);
+  if (!Layout || !Lowered)
+    return Lowered;
+
+  auto *Struct = cast<StructType>(Lowered);
+  SmallVector<llvm::Type *, 2> Eightbytes;
+  for (uint64_t Begin = 0; Begin < Layout->getSize(); Begin += 8) {
+    SmallVector<llvm::Type *, 2> Floats;
+    bool Integer = false;
+    for (auto [Field, FieldTy] :
+         llvm::zip(Layout->getFields(), Struct->elements())) {
+      if (Field.Offset < Begin || Field.Offset >= Begin + 8)
+        continue;
+      if (FieldTy->isFloatingPointTy())
+        Floats.push_back(FieldTy);
+      else
+        Integer = true;
+    }
+
+    uint64_t Size = std::min<uint64_t>(8, Layout->getSize() - Begin);
+    if (Integer || Floats.empty())
+      Eightbytes.push_back(IntegerType::get(Ctx, Size * 8));
+    else if (Floats.size() == 1)
+      Eightbytes.push_back(Floats.front());
+    else
+      Eightbytes.push_back(FixedVectorType::get(Floats.front(), Floats.size()));
+  }
+
+  if (Eightbytes.empty())
+    return Struct;
+  if (Eightbytes.size() == 1)
+    return Eightbytes.front();
+  return StructType::get(Ctx, Eightbytes);
+}
+
+FunctionCallee CodeGenModule::getRuntimeFunction(StringRef Name,
+                                                 FunctionType *Ty,
+                                                 bool GCLeaf) {
+  FunctionCallee Callee = M->getOrInsertFunction(Name, Ty);
+  // leaf functions cannot collect, their calls need no statepoint
+  if (GCLeaf)
+    cast<Function>(Callee.getCallee())->addFnAttr("gc-leaf-function");
+  return Callee;
+}
+
+// A heap map lists the offsets of the gc pointers of an object, which the
+// layout puts first: {i32 N, [N x i32] [0, 8, ...]}.
+GlobalVariable *CodeGenModule::getTypeId(const ObjectLayout &Layout) {
+  GlobalVariable *&Id = TypeIds[&Layout];
+  if (Id)
+    return Id;
+
+  auto *I32 = llvm::Type::getInt32Ty(Ctx);
+  SmallVector<Constant *, 8> Offsets;
+  for (const FieldLayout &Field :
+       Layout.getFields().take_front(Layout.getNumGCPointers()))
+    Offsets.push_back(ConstantInt::get(I32, Field.Offset));
+  auto *OffsetsTy = llvm::ArrayType::get(I32, Offsets.size());
+  Constant *Map = ConstantStruct::getAnon(
+      {ConstantInt::get(I32, Offsets.size()),
+       ConstantArray::get(OffsetsTy, Offsets)});
+
+  std::string Name = "rx.type." + std::to_string(HeapMaps.size());
+  auto *MapVar = new GlobalVariable(*M, Map->getType(), /*isConstant=*/true,
+                                    GlobalValue::PrivateLinkage, Map,
+                                    Name + ".map");
+  Id = new GlobalVariable(*M, I32, /*isConstant=*/false,
+                          GlobalValue::PrivateLinkage,
+                          ConstantInt::get(I32, 0), Name);
+  HeapMaps.push_back({Id, MapVar});
+  return Id;
+}
+
+Value *CodeGenModule::emitAllocation(IRBuilderBase &Builder,
+                                     const ObjectLayout &Layout) {
+  auto *I32 = Builder.getInt32Ty();
+  auto *GCPtr = llvm::PointerType::get(Ctx, GCAddressSpace);
+  FunctionCallee Allocate = getRuntimeFunction(
+      "runtime_allocate_typed",
+      FunctionType::get(GCPtr, {Builder.getInt64Ty(), I32}, false));
+
+  Value *Type = ConstantInt::get(I32, 0);
+  if (Layout.getNumGCPointers()) {
+    GlobalVariable *Id = getTypeId(Layout);
+    Type = Builder.CreateLoad(I32, Id, "type");
+  }
+  return Builder.CreateCall(
+      Allocate, {Builder.getInt64(Layout.getSize()), Type}, "obj");
+}
+
+void CodeGenModule::emitFieldStore(IRBuilderBase &Builder, Value *Obj,
+                                   const FieldLayout &Field, Value *V) {
+  Value *Addr = Builder.CreateConstInBoundsGEP1_64(Builder.getInt8Ty(), Obj,
+                                                   Field.Offset, Field.Name);
+  Builder.CreateStore(V, Addr);
+  if (!Field.IsGCPointer)
+    return;
+
+  auto *GCPtr = llvm::PointerType::get(Ctx, GCAddressSpace);
+  FunctionCallee Barrier = getRuntimeFunction(
+      "runtime_write_barrier",
+      FunctionType::get(Builder.getVoidTy(), {GCPtr, GCPtr}, false),
+      /*GCLeaf=*/true);
+  Builder.CreateCall(Barrier, {Obj, V});
+}
+
+Value *CodeGenModule::emitFieldLoad(IRBuilderBase &Builder, Value *Obj,
+                                    const FieldLayout &Field, llvm::Type *Ty) {
+  Value *Addr = Builder.CreateConstInBoundsGEP1_64(Builder.getInt8Ty(), Obj,
+                                                   Field.Offset, Field.Name);
+  return Builder.CreateLoad(Ty, Addr, Field.Name);
+}
+
+// The struct of a value type has the offsets of its object layout, so the
+// box is written and read as a whole.
+Value *CodeGenModule::emitBox(IRBuilderBase &Builder, const ObjectLayout &Layout,
+                              Value *V) {
+  Value *Box = emitAllocation(Builder, Layout);
+  Builder.CreateStore(V, Box);
+  return Box;
+}
+
+Value *CodeGenModule::emitUnbox(IRBuilderBase &Builder, Value *Box,
+                                llvm::Type *Ty) {
+  return Builder.CreateLoad(Ty, Box, "unbox");
+}
+
+// The payload area of an inline enum is an array of integers as wide as its
+// alignment, the tag follows at its natural offset.
+llvm::Type *CodeGenModule::lowerEnumType(const EnumLayout &Layout) {
+  auto *Tag = IntegerType::get(Ctx, Layout.getTagSize() * 8);
+  switch (Layout.getKind()) {
+  case EnumLayout::Kind::Tag:
+    return Tag;
+  case EnumLayout::Kind::NullablePointer:
+  case EnumLayout::Kind::Boxed:
+    return llvm::PointerType::get(Ctx, GCAddressSpace);
+  case EnumLayout::Kind::Inline: {
+    uint64_t Align = Layout.getDataAlignment();
+    auto *Data = llvm::ArrayType::get(IntegerType::get(Ctx, Align * 8),
+                                      Layout.getTagOffset() / Align);
+    return StructType::get(Ctx, {Data, Tag});
+  }
+  }
+  llvm_unreachable("Unaccounted for enum layout kind");
+}
+
+FunctionType *CodeGenModule::lowerFuncType(const FuncType *Ty,
+                                           SourceLocation Loc) {
+  llvm::Type *RetTy = lowerABIType(Ty->getReturnType(), Loc);
+  SmallVector<llvm::Type *, 8> Params;
+  for (QualType P : Ty->getParamTypes())
+    Params.push_back(lowerABIType(P, Loc));
+  if (!RetTy || is_contained(Params, nullptr))
+    return nullptr;
+  return FunctionType::get(RetTy, Params, /*isVarArg=*/false);
+}
+
+// Symbols are `package.name` and `package.Type.name` for methods. Overloaded
+// functions append their parameter types, as in `main.max(i32,i32)`.
+std::string CodeGenModule::mangle(Decl *D, ProgramDecl *Program,
+                                  ImplDecl *Impl) const {
+  std::string Name =
+      Program->getPackage() ? Program->getPackage()->getName().str() : "main";
+  Name += ".";
+  if (Impl) {
+    Name += Impl->getDeclaredType()->getType().getTypeName();
+    Name += ".";
+  }
+  Name += D->getName();
+
+  auto *F = dynamic_cast<FuncDecl *>(D);
+  LexicalScope *Declaring =
+      F && F->getLexicalScope() ? F->getLexicalScope()->parent() : nullptr;
+  if (Declaring && Declaring->getDecls(F->getName()).size() > 1) {
+    Name += "(";
+    for (auto [Idx, P] : llvm::enumerate(getFuncType(F)->getParamTypes())) {
+      if (Idx)
+        Name += ",";
+      Name += P.getTypeName();
+    }
+    Name += ")";
+  }
+  return Name;
+}
+
+void CodeGenModule::declareFunction(FuncDecl *Decl, ProgramDecl *Program,
+                                    ImplDecl *Impl, bool Exported) {
+  const FuncType *FT = getFuncType(Decl);
+  if (!FT)
+    return;
+  FunctionType *Ty = lowerFuncType(FT, Decl->getDeclLoc());
+  if (!Ty)
+    return;
+
+  auto Linkage =
+      Exported ? GlobalValue::ExternalLinkage : GlobalValue::InternalLinkage;
+  Function *F =
+      Function::Create(Ty, Linkage, mangle(Decl, Program, Impl), *M);
+  F->setGC(GCStrategy.str());
+  Functions[Decl] = F;
+}
+
+void CodeGenModule::declareGlobal(VarDecl *Decl, ProgramDecl *Program,
+                                  bool Exported) {
+  llvm::Type *Ty = lowerType(Decl->getType(), Decl->getDeclLoc());
+  if (!Ty)
+    return;
+
+  Constant *Init = nullptr;
+  if (Decl->getInitializer())
+    Init = emitConstantInitializer(Decl->getInitializer(), Ty);
+  // a constant initialized global that is never modified is read only, so
+  // loads of it fold to its value
+  bool IsConstant = Init && !Decl->isModified();
+  if (!Init)
+    Init = Constant::getNullValue(Ty);
+
+  auto Linkage =
+      Exported ? GlobalValue::ExternalLinkage : GlobalValue::InternalLinkage;
+  auto *G = new GlobalVariable(*M, Ty, IsConstant, Linkage, Init,
+                               mangle(Decl, Program, nullptr));
+  Globals[Decl] = G;
+
+  // the collector moves what they point to, so it has to find them
+  if (IsConstant)
+    return;
+  SmallVector<uint64_t, 4> Offsets;
+  collectGCPointers(Ty, 0, M->getDataLayout(), Offsets);
+  auto *I64 = llvm::Type::getInt64Ty(Ctx);
+  for (uint64_t Offset : Offsets)
+    GlobalRoots.push_back(ConstantExpr::getInBoundsGetElementPtr(
+        llvm::Type::getInt8Ty(Ctx), G, ConstantInt::get(I64, Offset)));
+}
+
+Constant *CodeGenModule::emitConstant(const ConstantValue &V) {
+  if (V.isInt())
+    return ConstantInt::get(Ctx, V.getInt());
+  return ConstantFP::get(Ctx, V.getFloat());
+}
+
+Constant *CodeGenModule::emitConstantInitializer(Expression *E,
+                                                 llvm::Type *Ty) {
+  if (const ConstantValue *V = E->getConstantValue()) {
+    Constant *C = emitConstant(*V);
+    return C->getType() == Ty ? C : nullptr;
+  }
+  if (auto *S = dynamic_cast<ast::StringLiteral *>(E))
+    return emitStringLiteral(S->getValue());
+
+  auto *Literal = dynamic_cast<ObjectLiteral *>(E);
+  const ObjectLayout *Layout =
+      Literal ? getValueLayout(E->getExprType()) : nullptr;
+  if (!Layout)
+    return nullptr;
+  auto *STy = cast<StructType>(Ty);
+  SmallVector<Constant *, 4> Fields;
+  for (auto [Idx, Field] : llvm::enumerate(Layout->getFields())) {
+    Constant *C = emitConstantInitializer(
+        Literal->getFields().lookup(Field.Name), STy->getElementType(Idx));
+    if (!C)
+      return nullptr;
+    Fields.push_back(C);
+  }
+  return ConstantStruct::get(STy, Fields);
+}
+
+// A literal is a whole string object in read-only data: the header of
+// runtime/object_header.h with object_static set, which the collector never
+// moves or frees, and the payload of runtime/string_object.h. The value is
+// the address of the payload, as for heap objects.
+Constant *CodeGenModule::emitStringLiteral(StringRef Value) {
+  constexpr uint64_t HeaderSize = sizeof(object_metadata);
+
+  auto *I8 = llvm::Type::getInt8Ty(Ctx);
+  GlobalVariable *&G = StringLiterals[Value];
+  if (!G) {
+    uint64_t Length = Value.size();
+    uint64_t Size = alignTo(str::payload_size(Length), 8);
+
+    // zero padded, which terminates the bytes. Literals are only emitted
+    // for the host, so the header and the tags are stored as the runtime
+    // reads them.
+    SmallVector<uint8_t, 64> Bytes(HeaderSize + Size, 0);
+    object_metadata Header{};
+    Header.flags = object_static;
+    Header.granules = std::min<uint64_t>(Size / 8, UINT16_MAX);
+    std::memcpy(Bytes.data(), &Header, HeaderSize);
+    uint8_t *Payload = &Bytes[HeaderSize];
+    if (Length <= str::kMaxShortLength) {
+      Payload[0] = str::short_tag(Length);
+      llvm::copy(Value, Payload + 1);
+    } else {
+      uint64_t Tag = str::long_tag(Length);
+      std::memcpy(Payload, &Tag, sizeof(Tag));
+      llvm::copy(Value, Payload + str::kLongDataOffset);
+    }
+
+    Constant *Init = ConstantDataArray::get(Ctx, ArrayRef<uint8_t>(Bytes));
+    std::string Name = "rx.str." + std::to_string(StringLiterals.size() - 1);
+    G = new GlobalVariable(*M, Init->getType(), /*isConstant=*/true,
+                           GlobalValue::PrivateLinkage, Init, Name);
+    G->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+    G->setAlignment(Align(8));
+  }
+
+  Constant *Payload = ConstantExpr::getInBoundsGetElementPtr(
+      I8, G, ConstantInt::get(llvm::Type::getInt64Ty(Ctx), HeaderSize));
+  return ConstantExpr::getAddrSpaceCast(
+      Payload, llvm::PointerType::get(Ctx, GCAddressSpace));
+}
+
+Value *CodeGenModule::emitStringConcat(IRBuilderBase &Builder, Value *L,
+                                       Value *R) {
+  auto *GCPtr = llvm::PointerType::get(Ctx, GCAddressSpace);
+  FunctionCallee Concat = getRuntimeFunction(
+      "runtime_string_concat", FunctionType::get(GCPtr, {GCPtr, GCPtr}, false));
+  return Builder.CreateCall(Concat, {L, R}, "concat");
+}
+
+Value *CodeGenModule::emitStringEqual(IRBuilderBase &Builder, Value *L,
+                                      Value *R) {
+  auto *GCPtr = llvm::PointerType::get(Ctx, GCAddressSpace);
+  FunctionCallee Equal = getRuntimeFunction(
+      "runtime_string_equal",
+      FunctionType::get(Builder.getInt1Ty(), {GCPtr, GCPtr}, false),
+      /*GCLeaf=*/true);
+  return Builder.CreateCall(Equal, {L, R}, "equal");
+}
+
+Value *CodeGenModule::emitStringCompare(IRBuilderBase &Builder, Value *L,
+                                        Value *R) {
+  auto *GCPtr = llvm::PointerType::get(Ctx, GCAddressSpace);
+  FunctionCallee Compare = getRuntimeFunction(
+      "runtime_string_compare",
+      FunctionType::get(Builder.getInt32Ty(), {GCPtr, GCPtr}, false),
+      /*GCLeaf=*/true);
+  return Builder.CreateCall(Compare, {L, R}, "compare");
+}
+
+Function *CodeGenModule::createInitFunction(ProgramDecl *Program) {
+  std::string Name =
+      Program->getPackage() ? Program->getPackage()->getName().str() : "main";
+  auto *F = Function::Create(FunctionType::get(llvm::Type::getVoidTy(Ctx), false),
+                             GlobalValue::InternalLinkage, Name + ".init", *M);
+  F->setGC(GCStrategy.str());
+  InitFunctions.push_back(F);
+  return F;
+}
+
+void CodeGenModule::addProgram(ProgramDecl *Program) {
+  Programs.push_back(Program);
+}
+
+// The runtime calls `int program_entry()` as its root task.
+void CodeGenModule::emitEntryPoint(ProgramDecl *Root) {
+  FuncDecl *Main = nullptr;
+  if (auto Scope = Root->getLexicalScope()) {
+    for (auto *D : Scope->getDecls("main"))
+      if ((Main = dynamic_cast<FuncDecl *>(D)))
+        break;
+  }
+  if (!Main) {
+    error(Root->Loc, "program has no 'main' function");
+    return;
+  }
+
+  Function *MainFn = getFunction(Main);
+  if (!MainFn)
+    return;
+  llvm::Type *RetTy = MainFn->getReturnType();
+  if (MainFn->arg_size() || !(RetTy->isVoidTy() || RetTy->isIntegerTy())) {
+    error(Main->getDeclLoc(),
+          "'main' must take no parameters and return unit or an integer");
+    return;
+  }
+
+  auto *I32 = llvm::Type::getInt32Ty(Ctx);
+  auto *Entry = Function::Create(FunctionType::get(I32, false),
+                                 GlobalValue::ExternalLinkage, "program_entry",
+                                 *M);
+  Entry->setGC(GCStrategy.str());
+
+  IRBuilder<> Builder(BasicBlock::Create(Ctx, "entry", Entry));
+  FunctionCallee Register = getRuntimeFunction(
+      "runtime_register_type",
+      FunctionType::get(I32, {llvm::PointerType::get(Ctx, 0)}, false),
+      /*GCLeaf=*/true);
+  for (auto [Id, Map] : HeapMaps)
+    Builder.CreateStore(Builder.CreateCall(Register, {Map}), Id);
+  FunctionCallee RegisterRoot = getRuntimeFunction(
+      "runtime_register_root",
+      FunctionType::get(llvm::Type::getVoidTy(Ctx),
+                        {llvm::PointerType::get(Ctx, 0)}, false),
+      /*GCLeaf=*/true);
+  for (Constant *Root : GlobalRoots)
+    Builder.CreateCall(RegisterRoot, {Root});
+  for (Function *Init : InitFunctions)
+    Builder.CreateCall(Init);
+  CallInst *Result = Builder.CreateCall(MainFn);
+  if (RetTy->isVoidTy())
+    Builder.CreateRet(Builder.getInt32(0));
+  else
+    Builder.CreateRet(Builder.CreateSExtOrTrunc(Result, I32));
+}
+
+std::unique_ptr<Module> CodeGenModule::generate(ProgramDecl *Root) {
+  for (auto *Program : Programs)
+    DeclareSymbols(*this, Program).start();
+  if (Errors)
+    return nullptr;
+
+  for (auto *Program : Programs)
+    EmitProgram(*this, Program).start();
+  emitEntryPoint(Root);
+  if (Errors)
+    return nullptr;
+
+  if (verifyModule(*M, &errs())) {
+    error(Root->Loc, "internal error: generated invalid IR");
+    return nullptr;
+  }
+  return std::move(M);
+}
+
+} // namespace rx::codegen
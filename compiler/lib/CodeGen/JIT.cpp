@@ -0,0 +1,126 @@
+#include "rxc/CodeGen/JIT.h"
+
+#include "runtime.h"
+#include "stackmap.h"
+
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
+#include <llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h>
+#include <llvm/ExecutionEngine/Orc/EPCEHFrameRegistrar.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+
+using namespace llvm;
+using namespace llvm::orc;
+
+namespace rx::codegen {
+
+namespace {
+
+constexpr StringLiteral StackMapSection = ".llvm_stackmaps";
+
+// Hands the stack map section of every linked object to the collector. No
+// symbol refers to the section, so it is kept alive through an anonymous
+// symbol before dead stripping, and registered once its relocations are
+// applied. The section is parsed on the next collection, before which the
+// code of the object cannot have reached a safepoint.
+class StackMapRegistrationPlugin : public ObjectLinkingLayer::Plugin {
+public:
+  void modifyPassConfig(MaterializationResponsibility &MR,
+                        jitlink::LinkGraph &G,
+                        jitlink::PassConfiguration &Config) override {
+    Config.PrePrunePasses.push_back([](jitlink::LinkGraph &G) {
+      if (auto *Sec = G.findSectionByName(StackMapSection))
+        for (auto *B : Sec->blocks())
+          G.addAnonymousSymbol(*B, 0, B->getSize(), false, true);
+      return Error::success();
+    });
+    Config.PostFixupPasses.push_back([](jitlink::LinkGraph &G) {
+      if (auto *Sec = G.findSectionByName(StackMapSection))
+        for (auto *B : Sec->blocks())
+          gc::statepoints.add_stackmaps(
+              B->getAddress().toPtr<const uint8_t *>());
+      return Error::success();
+    });
+  }
+
+  // code is never removed while the program runs
+  Error notifyFailed(MaterializationResponsibility &MR) override {
+    return Error::success();
+  }
+  Error notifyRemovingResources(JITDylib &JD, ResourceKey K) override {
+    return Error::success();
+  }
+  void notifyTransferringResources(JITDylib &JD, ResourceKey DstKey,
+                                   ResourceKey SrcKey) override {}
+};
+
+Expected<std::unique_ptr<ObjectLayer>>
+createObjectLinkingLayer(ExecutionSession &ES, const Triple &TT) {
+  auto Layer = std::make_unique<ObjectLinkingLayer>(ES);
+  auto EHFrameRegistrar = EPCEHFrameRegistrar::Create(ES);
+  if (!EHFrameRegistrar)
+    return EHFrameRegistrar.takeError();
+  Layer->addPlugin(std::make_unique<EHFrameRegistrationPlugin>(
+      ES, std::move(*EHFrameRegistrar)));
+  Layer->addPlugin(std::make_unique<StackMapRegistrationPlugin>());
+  return std::move(Layer);
+}
+
+} // namespace
+
+Expected<int> runInJIT(ThreadSafeModule TSM, const BackendOptions &Opts) {
+  auto JTMB = JITTargetMachineBuilder::detectHost();
+  if (!JTMB)
+    return JTMB.takeError();
+  JTMB->setCodeGenOptLevel(getCodeGenOptLevel(Opts));
+
+  auto TM = JTMB->createTargetMachine();
+  if (!TM)
+    return TM.takeError();
+  TSM.withModuleDo(
+      [&](Module &M) { runOptimizationPipeline(M, **TM, Opts); });
+
+  // Compiling on a thread of its own keeps LLVM off the small stacks of the
+  // runtime's tasks, which wait for the functions they call.
+  auto J = LLLazyJITBuilder()
+               .setJITTargetMachineBuilder(std::move(*JTMB))
+               .setNumCompileThreads(1)
+               .setObjectLinkingLayerCreator(createObjectLinkingLayer)
+               .create();
+  if (!J)
+    return J.takeError();
+
+  (*J)->setPartitionFunction(CompileOnDemandLayer::compileRequested);
+  (*J)->getIRTransformLayer().setTransform(
+      [Opts](ThreadSafeModule TSM, MaterializationResponsibility &R)
+          -> Expected<ThreadSafeModule> {
+        TSM.withModuleDo([&](Module &M) {
+          // libunwind walks JIT'd frames by their frame pointer where it
+          // does not find the registered eh frames
+          for (Function &F : M)
+            if (!F.isDeclaration())
+              F.addFnAttr("frame-pointer", "all");
+          lowerGCPointers(M, Opts);
+        });
+        return std::move(TSM);
+      });
+
+  // the runtime is part of the frontend, which exports its symbols
+  auto Process = DynamicLibrarySearchGenerator::GetForCurrentProcess(
+      (*J)->getDataLayout().getGlobalPrefix());
+  if (!Process)
+    return Process.takeError();
+  (*J)->getMainJITDylib().addGenerator(std::move(*Process));
+
+  if (auto Err = (*J)->addLazyIRModule(std::move(TSM)))
+    return std::move(Err);
+
+  auto Entry = (*J)->lookup("program_entry");
+  if (!Entry)
+    return Entry.takeError();
+  return runtime_start(Entry->toPtr<int (*)()>());
+}
+
+} // namespace rx::codegen
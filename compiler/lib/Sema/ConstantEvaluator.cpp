@@ -0,0 +1,190 @@
+#include "rxc/Sema/ConstantEvaluator.h"
+#include "rxc/AST/Type.h"
+
+using namespace rx::ast;
+using namespace llvm;
+
+namespace rx::sema {
+
+namespace {
+
+using Result = std::optional<ConstantValue>;
+
+Result getOperand(Expression *E) {
+  if (const ConstantValue *V = E->getConstantValue())
+    return *V;
+  return std::nullopt;
+}
+
+ConstantValue makeBool(bool B) {
+  return ConstantValue(APSInt(APInt(1, B), /*isUnsigned=*/true));
+}
+
+ConstantValue makeInt(APInt Int) {
+  unsigned Width = Int.getBitWidth();
+  return ConstantValue(APSInt(std::move(Int), /*isUnsigned=*/Width == 1));
+}
+
+// Numeric literals are converted to their type the way codegen lowered them
+// before they were folded: toward zero for integers and to the nearest
+// value for floats.
+Result evaluateNumber(const APFloat &Value, QualType T) {
+  const auto *BT = dynamic_cast<const BuiltinType *>(T.getType());
+  if (!BT)
+    return std::nullopt;
+
+  unsigned Width = 0;
+  switch (BT->getNativeType()) {
+  case NativeType::i1:
+    Width = 1;
+    break;
+  case NativeType::i8:
+    Width = 8;
+    break;
+  case NativeType::i16:
+    Width = 16;
+    break;
+  case NativeType::i32:
+    Width = 32;
+    break;
+  case NativeType::i64:
+    Width = 64;
+    break;
+  case NativeType::f32:
+  case NativeType::f64: {
+    APFloat Converted = Value;
+    bool LosesInfo;
+    Converted.convert(BT->getNativeType() == NativeType::f32
+                          ? APFloat::IEEEsingle()
+                          : APFloat::IEEEdouble(),
+                      APFloat::rmNearestTiesToEven, &LosesInfo);
+    return ConstantValue(std::move(Converted));
+  }
+  case NativeType::string:
+    return std::nullopt;
+  }
+
+  APSInt Int(Width, /*isUnsigned=*/Width == 1);
+  bool IsExact;
+  Value.convertToInteger(Int, APFloat::rmTowardZero, &IsExact);
+  return ConstantValue(std::move(Int));
+}
+
+Result evaluateInt(BinaryOp Op, const APInt &L, const APInt &R) {
+  switch (Op) {
+  case BinaryOp::Mult:
+    return makeInt(L * R);
+  case BinaryOp::Div:
+    // sdiv is undefined for these, keep the division in the program
+    if (R.isZero() || (L.isMinSignedValue() && R.isAllOnes()))
+      return std::nullopt;
+    return makeInt(L.sdiv(R));
+  case BinaryOp::Add:
+    return makeInt(L + R);
+  case BinaryOp::Sub:
+    return makeInt(L - R);
+  case BinaryOp::Less:
+    return makeBool(L.slt(R));
+  case BinaryOp::Greater:
+    return makeBool(L.sgt(R));
+  case BinaryOp::LessThanEqual:
+    return makeBool(L.sle(R));
+  case BinaryOp::GreaterThanEqual:
+    return makeBool(L.sge(R));
+  case BinaryOp::CmpEqual:
+    return makeBool(L == R);
+  case BinaryOp::CmpNotEqual:
+    return makeBool(L != R);
+  case BinaryOp::Equal:
+    break;
+  }
+  return std::nullopt;
+}
+
+// Comparisons are ordered except for `!=`, as the fcmp codegen emits.
+Result evaluateFloat(BinaryOp Op, APFloat L, const APFloat &R) {
+  auto RM = APFloat::rmNearestTiesToEven;
+  APFloat::cmpResult Cmp = L.compare(R);
+  switch (Op) {
+  case BinaryOp::Mult:
+    L.multiply(R, RM);
+    return ConstantValue(std::move(L));
+  case BinaryOp::Div:
+    L.divide(R, RM);
+    return ConstantValue(std::move(L));
+  case BinaryOp::Add:
+    L.add(R, RM);
+    return ConstantValue(std::move(L));
+  case BinaryOp::Sub:
+    L.subtract(R, RM);
+    return ConstantValue(std::move(L));
+  case BinaryOp::Less:
+    return makeBool(Cmp == APFloat::cmpLessThan);
+  case BinaryOp::Greater:
+    return makeBool(Cmp == APFloat::cmpGreaterThan);
+  case BinaryOp::LessThanEqual:
+    return makeBool(Cmp == APFloat::cmpLessThan || Cmp == APFloat::cmpEqual);
+  case BinaryOp::GreaterThanEqual:
+    return makeBool(Cmp == APFloat::cmpGreaterThan ||
+                    Cmp == APFloat::cmpEqual);
+  case BinaryOp::CmpEqual:
+    return makeBool(Cmp == APFloat::cmpEqual);
+  case BinaryOp::CmpNotEqual:
+    return makeBool(Cmp != APFloat::cmpEqual);
+  case BinaryOp::Equal:
+    break;
+  }
+  return std::nullopt;
+}
+
+Result evaluateBinary(BinaryExpr *E) {
+  Result L = getOperand(E->getLHS());
+  Result R = getOperand(E->getRHS());
+  if (!L || !R || L->isInt() != R->isInt())
+    return std::nullopt;
+  if (L->isInt()) {
+    if (L->getInt().getBitWidth() != R->getInt().getBitWidth())
+      return std::nullopt;
+    return evaluateInt(E->getOp(), L->getInt(), R->getInt());
+  }
+  if (&L->getFloat().getSemantics() != &R->getFloat().getSemantics())
+    return std::nullopt;
+  return evaluateFloat(E->getOp(), L->getFloat(), R->getFloat());
+}
+
+Result evaluateUnary(UnaryExpr *E) {
+  Result V = getOperand(E->getExpr());
+  if (!V)
+    return std::nullopt;
+  switch (E->getOp()) {
+  case UnaryOp::Negative:
+    if (V->isInt())
+      return makeInt(-V->getInt());
+    return ConstantValue(neg(V->getFloat()));
+  case UnaryOp::Not:
+    return makeBool(!V->getBool());
+  case UnaryOp::Ref:
+    break;
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+std::optional<ConstantValue> ConstantEvaluator::evaluate(Expression *E) {
+  if (E->getExprType().isUnknown())
+    return std::nullopt;
+  if (auto *N = dynamic_cast<NumLiteral *>(E))
+    return evaluateNumber(N->getValue(), E->getExprType());
+  if (auto *B = dynamic_cast<BoolLiteral *>(E))
+    return makeBool(B->getValue());
+  if (auto *C = dynamic_cast<CharLiteral *>(E))
+    return makeInt(APInt(8, static_cast<unsigned char>(C->getValue())));
+  if (auto *Binary = dynamic_cast<BinaryExpr *>(E))
+    return evaluateBinary(Binary);
+  if (auto *Unary = dynamic_cast<UnaryExpr *>(E))
+    return evaluateUnary(Unary);
+  return std::nullopt;
+}
+
+} // namespace rx::sema
@@ -26,45 +26,47 @@ public:
     auto *DeclaringLS = LS->parent();
     assert(DeclaringLS && "Missing declaring lexical scope");
 
-    for (auto *Decl : DeclaringLS->getDecls(Node->getName())) {
-      auto *F = dynamic_cast<FuncDecl *>(Decl);
-      if (!F) {
-        Diagnostic Err(Diagnostic::Type::Error,
-                       "Function cannot have the same name as another "
-                       "previously defined symbol'" +
-                           Node->getName().str() + "'");
-        Err.setSourceLocation(Node->getDeclLoc());
-        Diagnostic Note(Diagnostic::Type::Note, "Previously declared here");
-        Note.setSourceLocation(Decl->getDeclLoc());
-        DC.emit(std::move(Err));
-        DC.emit(std::move(Note));
-        return {};
-      }
-      // F is a function with the same symbol. Now do overload resolution
-      QualType OurFT = Node->getDeclaredType()->getType();
-      if (OurFT.isUnknown())
+    // a name is declared either by functions only or by another symbol
+    auto Decls = DeclaringLS->getDecls(Node->getName());
+    if (!Decls.empty() && !dynamic_cast<FuncDecl *>(Decls.front())) {
+      Diagnostic Err(Diagnostic::Type::Error,
+                     "Function cannot have the same name as another "
+                     "previously defined symbol'" +
+                         Node->getName().str() + "'");
+      Err.setSourceLocation(Node->getDeclLoc());
+      Diagnostic Note(Diagnostic::Type::Note, "Previously declared here");
+      Note.setSourceLocation(Decls.front()->getDeclLoc());
+      DC.emit(std::move(Err));
+      DC.emit(std::move(Note));
+      return {};
+    }
+
+    QualType OurFT = Node->getDeclaredType()->getType();
+    if (OurFT.isUnknown()) {
+      if (!Decls.empty())
         return {}; // bail out as we can't typecheck
-      auto OtherFT = F->getDeclaredType()->getType();
-
-      const auto *BaseFT = dynamic_cast<const FuncType *>(OtherFT.getType());
-      const auto *OurT = dynamic_cast<const FuncType *>(OurFT.getType());
-      assert(BaseFT && "Must be a function type");
-      assert(OurT && "Must be a function type");
-
-      if (BaseFT->getParamTypes() == OurT->getParamTypes()) {
-        Diagnostic Err(Diagnostic::Type::Error,
-                       "Overloaded function cannot have the same parameter "
-                       "types as another function with the same name");
-        Err.setSourceLocation(Node->getDeclLoc());
-        Diagnostic Note(Diagnostic::Type::Note, "Previously declared here");
-        Note.setSourceLocation(Decl->getDeclLoc());
-        DC.emit(std::move(Err));
-        DC.emit(std::move(Note));
-        return {};
-      }
+      DeclaringLS->insert(Node->getName(), Node);
+      return true;
+    }
+    const auto *OurT = dynamic_cast<const FuncType *>(OurFT.getType());
+    assert(OurT && "Must be a function type");
+
+    // overloads are indexed by their signature, which makes the check of a
+    // declaration independent of the number of overloads before it
+    const FuncType *Signature = TC.getSignature(OurT->getParamTypes());
+    if (FuncDecl *Other = DeclaringLS->getOverload(Node->getName(), Signature)) {
+      Diagnostic Err(Diagnostic::Type::Error,
+                     "Overloaded function cannot have the same parameter "
+                     "types as another function with the same name");
+      Err.setSourceLocation(Node->getDeclLoc());
+      Diagnostic Note(Diagnostic::Type::Note, "Previously declared here");
+      Note.setSourceLocation(Other->getDeclLoc());
+      DC.emit(std::move(Err));
+      DC.emit(std::move(Note));
+      return {};
     }
 
-    DeclaringLS->insert(Node->getName(), Node);
+    DeclaringLS->insertOverload(Node->getName(), Signature, Node);
     return true;
   }
 
@@ -21,6 +21,20 @@ void LexicalScope::insert(llvm::StringRef Symbol, ast::Decl *D) {
   Vec.push_back(D);
 }
 
+ast::FuncDecl *LexicalScope::getOverload(llvm::StringRef Symbol,
+                                        const FuncType *Signature) const {
+  auto It = Overloads.find(Symbol);
+  return It == Overloads.end() ? nullptr : It->second.lookup(Signature);
+}
+
+void LexicalScope::insertOverload(llvm::StringRef Symbol,
+                                  const FuncType *Signature, ast::FuncDecl *F) {
+  [[maybe_unused]] bool Inserted =
+      Overloads[Symbol].try_emplace(Signature, F).second;
+  assert(Inserted && "Overload with this signature is already declared");
+  insert(Symbol, F);
+}
+
 llvm::ArrayRef<ast::Decl *> LexicalScope::getDecls(llvm::StringRef Symbol) {
   if (!SymbolTable.contains(Symbol))
     return llvm::ArrayRef<ast::Decl *>();
@@ -72,6 +72,8 @@ private:
   DiagnosticConsumer &DC;
 };
 
+// Unlike the forward declarations, type references are resolved inside
+// function bodies too, for the annotations of local variables.
 class ResolveTypeSymbol final : public RecursiveASTVisitor<> {
 public:
   ResolveTypeSymbol(DiagnosticConsumer &DC, LexicalContext &LC)
@@ -115,10 +117,6 @@ private:
     return {};
   }
 
-  ResultType visit(ast::BlockStmt *Node, sema::LexicalScope *LS) override {
-    return {};
-  }
-
 private:
   DiagnosticConsumer &DC;
 };
@@ -263,8 +261,8 @@ public:
   QualType visit(ast::ASTEnumType *Node, sema::LexicalScope *LS) override {
     llvm::StringMap<QualType> Members;
     for (auto &M : Node->getMembers()) {
-      assert(M.second);
-      auto T = Visit(M.second);
+      // members without a payload carry unit
+      auto T = M.second ? Visit(M.second) : TC.getUnitType();
       if (T.isUnknown())
         return T;
       if (Members.contains(M.first)) {
@@ -281,10 +279,6 @@ public:
     return EnumTy;
   }
 
-  QualType visit(ast::BlockStmt *Node, sema::LexicalScope *LS) override {
-    return {};
-  }
-
 private:
   TypeContext &TC;
   LexicalContext &LC;
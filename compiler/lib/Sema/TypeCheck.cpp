@@ -5,6 +5,7 @@
 #include "rxc/AST/TypeContext.h"
 #include "rxc/Basic/Diagnostic.h"
 #include "rxc/Basic/SourceManager.h"
+#include "rxc/Sema/ConstantEvaluator.h"
 #include "rxc/Sema/LexicalScope.h"
 #include "rxc/Sema/RecursiveASTVisitor.h"
 #include "rxc/Sema/Sema.h"
@@ -25,7 +26,7 @@ public:
 private:
   struct HintCtxExit {
     HintCtxExit(SmallVectorImpl<QualType> &Impl, int n) : Stack(Impl), n(n) {}
-    ~HintCtxExit() { Stack.pop_back_n(n); }
+    ~HintCtxExit() { Stack.truncate(n); }
 
   private:
     SmallVectorImpl<QualType> &Stack;
@@ -38,6 +39,84 @@ private:
     return HintCtxExit(HintStack, n);
   }
 
+  QualType currentHint() const {
+    return HintStack.empty() ? QualType() : HintStack.back();
+  }
+
+  void emitError(SourceLocation Loc, std::string Message) {
+    Diagnostic Err(Diagnostic::Type::Error, std::move(Message));
+    Err.setSourceLocation(Loc);
+    DC.emit(std::move(Err));
+  }
+
+  static QualType getDeclType(Decl *D) {
+    if (auto *Var = dynamic_cast<VarDecl *>(D))
+      return Var->getType();
+    if (auto *Param = dynamic_cast<FuncParamDecl *>(D))
+      return Param->getType();
+    if (auto *Func = dynamic_cast<FuncDecl *>(D))
+      return Func->getDeclaredType()->getType();
+    return {};
+  }
+
+  // Named types are checked against their definition.
+  static QualType getDefinition(QualType T) {
+    if (const auto *Named = dynamic_cast<const NamedType *>(T.getType()))
+      return Named->getDecl()->getDeclaredType()->getType();
+    return T;
+  }
+
+  // Fields are reached through a pointer as well, as in `self.width`.
+  static const ObjectType *getAccessedObject(QualType T) {
+    if (const auto *Ptr = dynamic_cast<const PointerType *>(T.getType()))
+      T = Ptr->getPointeeType();
+    return dynamic_cast<const ObjectType *>(getDefinition(T).getType());
+  }
+
+  // Stores the value of a typed expression whose operands are constant, or
+  // clears the one of an earlier visit with another hint.
+  static QualType fold(Expression *Node, QualType T) {
+    Node->setExprType(T);
+    Node->setConstantValue(ConstantEvaluator::evaluate(Node));
+    return T;
+  }
+
+  // Variables that are assigned or whose address is taken are not constant.
+  static void markModified(Expression *E) {
+    if (auto *Ref = dynamic_cast<DeclRefExpr *>(E))
+      if (auto *Var = dynamic_cast<VarDecl *>(Ref->getRefDecl()))
+        Var->setModified();
+  }
+
+  static const BuiltinType *getBuiltin(QualType T) {
+    return dynamic_cast<const BuiltinType *>(T.getType());
+  }
+
+  static bool isNumeric(QualType T) {
+    const auto *BT = getBuiltin(T);
+    return BT && BT->getNativeType() != NativeType::i1 &&
+           BT->getNativeType() != NativeType::string;
+  }
+
+  static bool isString(QualType T) {
+    const auto *BT = getBuiltin(T);
+    return BT && BT->getNativeType() == NativeType::string;
+  }
+
+  static bool isComparison(BinaryOp Op) {
+    switch (Op) {
+    case BinaryOp::Less:
+    case BinaryOp::Greater:
+    case BinaryOp::LessThanEqual:
+    case BinaryOp::GreaterThanEqual:
+    case BinaryOp::CmpEqual:
+    case BinaryOp::CmpNotEqual:
+      return true;
+    default:
+      return false;
+    }
+  }
+
   bool checkAndEmitRedeclaration(Decl *Node, LexicalScope *LS) {
     if (auto Decls = LS->getDecls(Node->getName()); Decls.size()) {
       Diagnostic Err(Diagnostic::Type::Error, "Redefinition of declaration '" +
@@ -100,6 +179,7 @@ private:
 
     DeclTy = checkAndDeduceVarInit(Node->getDeclLoc(), DeclTy,
                                    Node->getInitializer());
+    Node->setType(DeclTy);
     LS->insert(Node->getName(), Node);
 
     return DeclTy;
@@ -130,22 +210,542 @@ private:
 
     DeclTy = checkAndDeduceVarInit(Node->getDeclLoc(), DeclTy,
                                    Node->getDefaultValue());
+    Node->setType(DeclTy);
     LS->insert(Node->getName(), Node);
     return DeclTy;
   }
 
-  QualType visit(BoolLiteral *Node, LexicalScope *LS) override {
-    auto T = TC.getBuiltinType(NativeType::i1);
+  QualType visit(FuncDecl *Node, LexicalScope *LS) override {
+    QualType FT = Node->getDeclaredType()->getType();
+    const auto *FuncT = dynamic_cast<const FuncType *>(FT.getType());
+    ReturnTypes.push_back(FuncT ? FuncT->getReturnType() : QualType());
+    for (auto *P : Node->getParams())
+      Visit(P);
+    if (Node->getBody())
+      Visit(Node->getBody());
+    ReturnTypes.pop_back();
+    return {};
+  }
+
+  QualType visit(ReturnStmt *Node, LexicalScope *LS) override {
+    QualType RetTy = ReturnTypes.empty() ? QualType() : ReturnTypes.back();
+    if (!Node->getExpr()) {
+      if (!RetTy.isUnknown() && RetTy.getType() != TC.getUnitType().getType())
+        emitError(Node->Loc, "non-void function must return a value of type '" +
+                                 RetTy.getTypeName() + "'");
+      return {};
+    }
+
+    auto _ = pushTypeHint(RetTy);
+    QualType T = Visit(Node->getExpr());
+    if (!T.isUnknown() && !RetTy.isUnknown() &&
+        T.getType() != RetTy.getType())
+      emitError(Node->Loc, "cannot return a value of type '" +
+                               T.getTypeName() + "' from a function returning '" +
+                               RetTy.getTypeName() + "'");
+    return {};
+  }
+
+  QualType visit(ForStmt *Node, LexicalScope *LS) override {
+    if (Node->getPreHeader())
+      Visit(Node->getPreHeader());
+    if (Node->getCondition())
+      checkCondition(Node->getCondition());
+    if (Node->getPostExpr())
+      Visit(Node->getPostExpr());
+    Visit(Node->getBody());
+    return {};
+  }
+
+  void checkCondition(Expression *Cond) {
+    auto _ = pushTypeHint(TC.getBuiltinType(NativeType::i1));
+    QualType T = Visit(Cond);
+    if (!T.isUnknown() &&
+        T.getType() != TC.getBuiltinType(NativeType::i1).getType())
+      emitError(Cond->Loc, "condition must be of type 'i1', found '" +
+                               T.getTypeName() + "'");
+  }
+
+  QualType visit(IfExpr *Node, LexicalScope *LS) override {
+    checkCondition(Node->getCondition());
+    Visit(Node->getBody());
+    if (Node->getElseBlock())
+      Visit(Node->getElseBlock());
+    QualType T = TC.getUnitType();
     Node->setExprType(T);
     return T;
   }
 
-  QualType visit(CharLiteral *Node, LexicalScope *LS) override {
-    auto T = TC.getBuiltinType(NativeType::i8);
+  QualType visit(DeclRefExpr *Node, LexicalScope *LS) override {
+    auto Scope = LS->find(Node->getSymbol());
+    if (!Scope) {
+      emitError(Node->Loc, "use of undeclared identifier '" +
+                               Node->getSymbol().str() + "'");
+      return {};
+    }
+    // overloaded functions are resolved by the call using them
+    auto *D = (*Scope)->getDecls(Node->getSymbol()).front();
+    QualType T = getDeclType(D);
+    Node->setRefDecl(D);
+    Node->setExprType(T);
+    return T;
+  }
+
+  QualType visit(BinaryExpr *Node, LexicalScope *LS) override {
+    bool Compare = isComparison(Node->getOp());
+    if (Node->getOp() == BinaryOp::Equal) {
+      emitError(Node->Loc, "unsupported binary operator");
+      return {};
+    }
+
+    QualType LHS, RHS;
+    {
+      // operands of comparisons do not take the i1 of the result
+      auto _ = pushTypeHint(Compare ? QualType() : currentHint());
+      LHS = Visit(Node->getLHS());
+    }
+    {
+      auto _ = pushTypeHint(LHS);
+      RHS = Visit(Node->getRHS());
+    }
+    // a literal on the left takes the type of the right, as in `1 + x`
+    if (dynamic_cast<NumLiteral *>(Node->getLHS()) && !RHS.isUnknown() &&
+        LHS.getType() != RHS.getType()) {
+      auto _ = pushTypeHint(RHS);
+      LHS = Visit(Node->getLHS());
+    }
+    if (LHS.isUnknown() || RHS.isUnknown())
+      return {};
+
+    bool Equality = Node->getOp() == BinaryOp::CmpEqual ||
+                    Node->getOp() == BinaryOp::CmpNotEqual;
+    // strings are concatenated with + and compared by their bytes
+    bool IsBool = LHS.getType() == TC.getBuiltinType(NativeType::i1).getType();
+    bool Valid = LHS.getType() == RHS.getType() &&
+                 (isNumeric(LHS) || (Equality && IsBool) ||
+                  (isString(LHS) &&
+                   (Compare || Node->getOp() == BinaryOp::Add)));
+    if (!Valid) {
+      emitError(Node->Loc, "invalid operands to binary expression ('" +
+                               LHS.getTypeName() + "' and '" +
+                               RHS.getTypeName() + "')");
+      return {};
+    }
+
+    return fold(Node, Compare ? TC.getBuiltinType(NativeType::i1) : LHS);
+  }
+
+  QualType visit(UnaryExpr *Node, LexicalScope *LS) override {
+    QualType T;
+    switch (Node->getOp()) {
+    case UnaryOp::Negative: {
+      auto _ = pushTypeHint(currentHint());
+      T = Visit(Node->getExpr());
+      if (!T.isUnknown() && !isNumeric(T)) {
+        emitError(Node->Loc, "cannot negate a value of type '" +
+                                 T.getTypeName() + "'");
+        return {};
+      }
+      break;
+    }
+    case UnaryOp::Not:
+      checkCondition(Node->getExpr());
+      T = TC.getBuiltinType(NativeType::i1);
+      break;
+    case UnaryOp::Ref: {
+      auto _ = pushTypeHint(QualType());
+      QualType Pointee = Visit(Node->getExpr());
+      if (!Pointee.isUnknown())
+        T = TC.getPointerType(Pointee);
+      markModified(Node->getExpr());
+      break;
+    }
+    }
+    return fold(Node, T);
+  }
+
+  // Checks the arguments against the parameter types. Literal arguments
+  // are typed with the parameter type as hint.
+  bool matchArguments(CallExpr *Node, ArrayRef<QualType> ParamTys) {
+    for (auto [Arg, ParamTy] : llvm::zip(Node->getArgs(), ParamTys)) {
+      auto _ = pushTypeHint(ParamTy);
+      QualType ArgTy = Visit(Arg);
+      if (ArgTy.isUnknown())
+        return false;
+      if (ArgTy.getType() != ParamTy.getType()) {
+        emitError(Arg->Loc, "cannot pass a value of type '" +
+                                ArgTy.getTypeName() +
+                                "' to a parameter of type '" +
+                                ParamTy.getTypeName() + "'");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether the literal can be typed as T without a diagnostic.
+  static bool literalConvertsTo(NumLiteral *Lit, QualType T) {
+    if (!isNumeric(T))
+      return false;
+    NativeType NT = getBuiltin(T)->getNativeType();
+    return Lit->isInteger() || NT == NativeType::f32 || NT == NativeType::f64;
+  }
+
+  // Types the arguments that are not literals, which have a type of their
+  // own; literals get an unknown type here and are typed once the callee is
+  // chosen. Returns false if an argument has no type.
+  bool typeNonLiteralArgs(CallExpr *Node, SmallVectorImpl<QualType> &ArgTys) {
+    for (auto *Arg : Node->getArgs()) {
+      if (dynamic_cast<NumLiteral *>(Arg)) {
+        ArgTys.push_back({});
+        continue;
+      }
+      auto _ = pushTypeHint(QualType());
+      ArgTys.push_back(Visit(Arg));
+      if (ArgTys.back().isUnknown())
+        return false;
+    }
+    return true;
+  }
+
+  bool isViable(CallExpr *Node, ArrayRef<QualType> ArgTys,
+                ArrayRef<QualType> ParamTys) {
+    bool Viable = true;
+    for (auto [Arg, ArgTy, ParamTy] :
+         llvm::zip(Node->getArgs(), ArgTys, ParamTys)) {
+      auto *Lit = dynamic_cast<NumLiteral *>(Arg);
+      Viable &= Lit ? literalConvertsTo(Lit, ParamTy)
+                    : ArgTy.getType() == ParamTy.getType();
+    }
+    return Viable;
+  }
+
+  void typeLiteralArgs(CallExpr *Node, ArrayRef<QualType> ParamTys) {
+    for (auto [Arg, ParamTy] : llvm::zip(Node->getArgs(), ParamTys)) {
+      if (!dynamic_cast<NumLiteral *>(Arg))
+        continue;
+      auto _ = pushTypeHint(ParamTy);
+      Visit(Arg);
+    }
+  }
+
+  // Arguments that are not literals have a type of their own, a call with
+  // only such arguments resolves to the overload of their signature in one
+  // lookup. Returns std::nullopt if an argument has no type.
+  std::optional<FuncDecl *> findOverload(CallExpr *Node, DeclRefExpr *Callee,
+                                         LexicalScope *Scope) {
+    llvm::SmallVector<QualType, 8> ArgTys;
+    for (auto *Arg : Node->getArgs()) {
+      auto _ = pushTypeHint(QualType());
+      ArgTys.push_back(Visit(Arg));
+      if (ArgTys.back().isUnknown())
+        return std::nullopt;
+    }
+    return Scope->getOverload(Callee->getSymbol(), TC.getSignature(ArgTys));
+  }
+
+  QualType visit(CallExpr *Node, LexicalScope *LS) override {
+    // a call is resolved once, visiting it again reuses its callee
+    if (Node->getCalleeDecl())
+      return Node->getExprType();
+
+    if (auto *Method = dynamic_cast<AccessExpr *>(Node->getCallee()))
+      return visitMethodCall(Node, Method, LS);
+
+    // calls of function values are not typed yet
+    auto *Callee = dynamic_cast<DeclRefExpr *>(Node->getCallee());
+    if (!Callee)
+      return {};
+
+    auto Scope = LS->find(Callee->getSymbol());
+    if (!Scope) {
+      emitError(Callee->Loc, "use of undeclared identifier '" +
+                                 Callee->getSymbol().str() + "'");
+      return {};
+    }
+
+    auto Decls = (*Scope)->getDecls(Callee->getSymbol());
+    bool HasLiteralArgs = llvm::any_of(Node->getArgs(), [](Expression *Arg) {
+      return dynamic_cast<NumLiteral *>(Arg) != nullptr;
+    });
+    if (Decls.size() > 1 && !HasLiteralArgs) {
+      auto Found = findOverload(Node, Callee, *Scope);
+      if (!Found)
+        return {};
+      if (*Found)
+        return setCallee(Node, Callee, *Found);
+      // the candidates below diagnose the mismatch
+    }
+
+    llvm::SmallVector<FuncDecl *, 4> Candidates;
+    for (auto *D : Decls) {
+      auto *F = dynamic_cast<FuncDecl *>(D);
+      const auto *FT =
+          F ? dynamic_cast<const FuncType *>(getDeclType(F).getType())
+            : nullptr;
+      if (FT && FT->getParamTypes().size() == Node->getArgs().size())
+        Candidates.push_back(F);
+    }
+
+    FuncDecl *Match = nullptr;
+    if (Candidates.size() == 1) {
+      Match = Candidates.front();
+      const auto *FT =
+          dynamic_cast<const FuncType *>(getDeclType(Match).getType());
+      if (!matchArguments(Node, FT->getParamTypes()))
+        return {};
+    } else if (Candidates.size() > 1) {
+      // only the type of literal arguments depends on the candidate, the
+      // other ones are typed once
+      llvm::SmallVector<QualType, 8> ArgTys;
+      if (!typeNonLiteralArgs(Node, ArgTys))
+        return {};
+
+      for (auto *F : Candidates) {
+        const auto *FT =
+            dynamic_cast<const FuncType *>(getDeclType(F).getType());
+        if (!isViable(Node, ArgTys, FT->getParamTypes()))
+          continue;
+        if (Match) {
+          emitError(Node->Loc, "call to overloaded function '" +
+                                   Callee->getSymbol().str() +
+                                   "' is ambiguous");
+          return {};
+        }
+        Match = F;
+      }
+
+      if (Match) {
+        const auto *FT =
+            dynamic_cast<const FuncType *>(getDeclType(Match).getType());
+        typeLiteralArgs(Node, FT->getParamTypes());
+      }
+    }
+
+    if (!Match) {
+      emitError(Node->Loc, "no matching function for call to '" +
+                               Callee->getSymbol().str() + "'");
+      return {};
+    }
+
+    return setCallee(Node, Callee, Match);
+  }
+
+  // The receiver is passed by reference to a method taking self by pointer
+  // and dereferenced for one taking self by value.
+  static bool acceptsReceiver(QualType Self, QualType Receiver) {
+    auto PointsTo = [](QualType Ptr, QualType Pointee) {
+      const auto *PT = dynamic_cast<const PointerType *>(Ptr.getType());
+      return PT && PT->getPointeeType().getType() == Pointee.getType();
+    };
+    return Self.getType() == Receiver.getType() || PointsTo(Self, Receiver) ||
+           PointsTo(Receiver, Self);
+  }
+
+  // Methods are found by name in the impls of the named type of the
+  // receiver, or of the type it points to, and take the receiver as their
+  // first parameter. The receiver type is always known, so a method call
+  // resolves to a single function like any other call.
+  QualType visitMethodCall(CallExpr *Node, AccessExpr *Method,
+                           LexicalScope *LS) {
+    // calls qualified by a package, as in `io.print`, are not typed yet
+    auto *Package = dynamic_cast<DeclRefExpr *>(Method->getExpr());
+    if (Package && !LS->find(Package->getSymbol()))
+      return {};
+
+    QualType Receiver;
+    {
+      auto _ = pushTypeHint(QualType());
+      Receiver = Visit(Method->getExpr());
+    }
+    if (Receiver.isUnknown())
+      return {};
+
+    QualType Base = Receiver;
+    if (const auto *Ptr = dynamic_cast<const PointerType *>(Base.getType()))
+      Base = Ptr->getPointeeType();
+    const auto *Named = dynamic_cast<const NamedType *>(Base.getType());
+    ArrayRef<FuncDecl *> Methods;
+    if (Named)
+      Methods = Named->getMethods(Method->getAccessor());
+    if (Methods.empty()) {
+      // calls of function values are not typed yet
+      const ObjectType *Obj = getAccessedObject(Receiver);
+      if (Obj && Obj->getFields().count(Method->getAccessor()))
+        return {};
+      emitError(Method->Loc, "no method named '" +
+                                 Method->getAccessor().str() +
+                                 "' for a receiver of type '" +
+                                 Receiver.getTypeName() + "'");
+      return {};
+    }
+
+    llvm::SmallVector<FuncDecl *, 4> Candidates;
+    for (auto *F : Methods) {
+      const auto *FT = dynamic_cast<const FuncType *>(getDeclType(F).getType());
+      if (FT && FT->getParamTypes().size() == Node->getArgs().size() + 1 &&
+          acceptsReceiver(FT->getParamTypes().front(), Receiver))
+        Candidates.push_back(F);
+    }
+
+    // like for functions, a single candidate types the arguments with its
+    // parameter types as hints
+    FuncDecl *Match = nullptr;
+    if (Candidates.size() == 1) {
+      Match = Candidates.front();
+      const auto *FT =
+          dynamic_cast<const FuncType *>(getDeclType(Match).getType());
+      if (!matchArguments(Node, FT->getParamTypes().drop_front()))
+        return {};
+    } else if (Candidates.size() > 1) {
+      llvm::SmallVector<QualType, 8> ArgTys;
+      if (!typeNonLiteralArgs(Node, ArgTys))
+        return {};
+
+      for (auto *F : Candidates) {
+        const auto *FT =
+            dynamic_cast<const FuncType *>(getDeclType(F).getType());
+        if (!isViable(Node, ArgTys, FT->getParamTypes().drop_front()))
+          continue;
+        if (Match) {
+          emitError(Node->Loc, "call to overloaded method '" +
+                                   Method->getAccessor().str() +
+                                   "' is ambiguous");
+          return {};
+        }
+        Match = F;
+      }
+
+      if (Match) {
+        const auto *FT =
+            dynamic_cast<const FuncType *>(getDeclType(Match).getType());
+        typeLiteralArgs(Node, FT->getParamTypes().drop_front());
+      }
+    }
+
+    if (!Match) {
+      emitError(Node->Loc, "no matching method for call to '" +
+                               Method->getAccessor().str() + "'");
+      return {};
+    }
+
+    const auto *FT = dynamic_cast<const FuncType *>(getDeclType(Match).getType());
+    Method->setExprType(FT);
+    Node->setCalleeDecl(Match);
+    Node->setExprType(FT->getReturnType());
+    return FT->getReturnType();
+  }
+
+  QualType setCallee(CallExpr *Node, DeclRefExpr *Callee, FuncDecl *F) {
+    const auto *FT = dynamic_cast<const FuncType *>(getDeclType(F).getType());
+    Callee->setRefDecl(F);
+    Callee->setExprType(FT);
+    Node->setCalleeDecl(F);
+    Node->setExprType(FT->getReturnType());
+    return FT->getReturnType();
+  }
+
+  QualType visit(AssignExpr *Node, LexicalScope *LS) override {
+    QualType LHS;
+    {
+      auto _ = pushTypeHint(QualType());
+      LHS = Visit(Node->getLHS());
+    }
+    auto _ = pushTypeHint(LHS);
+    QualType RHS = Visit(Node->getRHS());
+    if (LHS.isUnknown() || RHS.isUnknown())
+      return {};
+
+    auto *Ref = dynamic_cast<DeclRefExpr *>(Node->getLHS());
+    bool Assignable = Ref ? !dynamic_cast<FuncDecl *>(Ref->getRefDecl())
+                          : dynamic_cast<AccessExpr *>(Node->getLHS()) != nullptr;
+    if (!Assignable) {
+      emitError(Node->Loc, "expression is not assignable");
+      return {};
+    }
+    if (LHS.getType() != RHS.getType()) {
+      emitError(Node->Loc, "cannot assign a value of type '" +
+                               RHS.getTypeName() + "' to a variable of type '" +
+                               LHS.getTypeName() + "'");
+      return {};
+    }
+    if (auto *Access = dynamic_cast<AccessExpr *>(Node->getLHS()))
+      TC.addMutatedObject(
+          getAccessedObject(Access->getExpr()->getExprType()));
+    markModified(Node->getLHS());
+    Node->setExprType(LHS);
+    return LHS;
+  }
+
+  QualType visit(AccessExpr *Node, LexicalScope *LS) override {
+    QualType ObjTy;
+    {
+      auto _ = pushTypeHint(QualType());
+      ObjTy = Visit(Node->getExpr());
+    }
+    if (ObjTy.isUnknown())
+      return {};
+
+    const ObjectType *Obj = getAccessedObject(ObjTy);
+    if (!Obj) {
+      emitError(Node->Loc, "member access into a value of non-object type '" +
+                               ObjTy.getTypeName() + "'");
+      return {};
+    }
+    auto It = Obj->getFields().find(Node->getAccessor());
+    if (It == Obj->getFields().end()) {
+      emitError(Node->Loc, "no field named '" + Node->getAccessor().str() +
+                               "' in '" + ObjTy.getTypeName() + "'");
+      return {};
+    }
+    QualType T = It->getValue();
+    Node->setExprType(T);
+    return T;
+  }
+
+  QualType visit(IndexExpr *Node, LexicalScope *LS) override { return {}; }
+
+  QualType visit(ObjectLiteral *Node, LexicalScope *LS) override {
+    QualType Hint = currentHint();
+    const auto *Expected =
+        dynamic_cast<const ObjectType *>(getDefinition(Hint).getType());
+
+    llvm::StringMap<QualType> Fields;
+    for (auto &F : Node->getFields()) {
+      QualType FieldHint;
+      if (Expected) {
+        auto It = Expected->getFields().find(F.getKey());
+        if (It == Expected->getFields().end()) {
+          emitError(F.getValue()->Loc, "no field named '" + F.getKey().str() +
+                                           "' in '" + Hint.getTypeName() +
+                                           "'");
+          return {};
+        }
+        FieldHint = It->getValue();
+      }
+      auto _ = pushTypeHint(FieldHint);
+      QualType T = Visit(F.getValue());
+      if (T.isUnknown())
+        return {};
+      Fields[F.getKey()] = T;
+    }
+
+    QualType T = TC.getObjectType(std::move(Fields));
+    // an object literal initializes the named type it is checked against
+    if (Expected && T.getType() == Expected)
+      T = Hint;
     Node->setExprType(T);
     return T;
   }
 
+  QualType visit(BoolLiteral *Node, LexicalScope *LS) override {
+    return fold(Node, TC.getBuiltinType(NativeType::i1));
+  }
+
+  QualType visit(CharLiteral *Node, LexicalScope *LS) override {
+    return fold(Node, TC.getBuiltinType(NativeType::i8));
+  }
+
   QualType deduceNumericType(NumLiteral *Node, NativeType NT) {
     if (!Node->isInteger()) {
       switch (NT) {
@@ -211,7 +811,7 @@ private:
       case NativeType::i1:
         return TC.getBuiltinType(NativeType::i1);
       case NativeType::i8:
-        return TC.getBuiltinType(NativeType::i1);
+        return TC.getBuiltinType(NativeType::i8);
       case NativeType::i16:
         return TC.getBuiltinType(NativeType::i16);
       case NativeType::i32:
@@ -234,20 +834,16 @@ private:
   }
 
   QualType visit(NumLiteral *Node, LexicalScope *LS) override {
-    QualType Hint = HintStack.back();
+    const auto *BaseType = getBuiltin(currentHint());
     QualType T;
 
-    if (Hint.isUnknown()) {
+    if (!BaseType) {
       T = Node->isInteger() ? TC.getBuiltinType(NativeType::i64)
                             : TC.getBuiltinType(NativeType::f64);
     } else {
-      const auto *BaseType = dynamic_cast<const BuiltinType *>(Hint.getType());
-      if (BaseType) {
-        T = deduceNumericType(Node, BaseType->getNativeType());
-      }
+      T = deduceNumericType(Node, BaseType->getNativeType());
     }
-    Node->setExprType(T);
-    return T;
+    return fold(Node, T);
   }
 
   QualType visit(ast::StringLiteral *Node, LexicalScope *LS) override {
@@ -262,6 +858,7 @@ private:
 
 private:
   llvm::SmallVector<QualType, 16> HintStack;
+  llvm::SmallVector<QualType, 4> ReturnTypes;
 };
 
 void TypeCheck::run(ast::ProgramDecl *Program, DiagnosticConsumer &DC,
@@ -0,0 +1,244 @@
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace llvm;
+
+namespace {
+
+#define DEBUG_TYPE "gc-escape"
+
+STATISTIC(NumStackObjects, "Number of gc allocations moved to the stack");
+STATISTIC(NumStackBytes, "Number of payload bytes moved to the stack");
+
+cl::opt<unsigned> MaxStackObjectSize(
+    "gc-escape-max-size", cl::init(256),
+    cl::desc("Largest gc allocation in bytes to move to the stack"));
+
+// Allocation entry points of the runtime, all taking the payload size as
+// their first argument and returning a zeroed object.
+constexpr StringRef AllocFunctions[] = {
+    "runtime_allocate", "runtime_allocate_typed", "runtime_allocate_inline"};
+
+// Runtime functions that only look at the address of an object.
+constexpr StringRef NonCapturingFunctions[] = {"runtime_inspect_ptr"};
+
+constexpr unsigned GCAddressSpace = 1;
+
+bool containsGCPointer(Type *T) {
+  if (auto *Ptr = dyn_cast<PointerType>(T))
+    return Ptr->getAddressSpace() == GCAddressSpace;
+  if (auto *Vec = dyn_cast<VectorType>(T))
+    return containsGCPointer(Vec->getElementType());
+  if (auto *Arr = dyn_cast<ArrayType>(T))
+    return containsGCPointer(Arr->getElementType());
+  if (auto *ST = dyn_cast<StructType>(T))
+    return any_of(ST->elements(), containsGCPointer);
+  return false;
+}
+
+bool isAllocation(const CallBase &CB) {
+  const Function *Callee = CB.getCalledFunction();
+  return Callee && is_contained(AllocFunctions, Callee->getName());
+}
+
+bool isDeallocation(const CallBase &CB) {
+  const Function *Callee = CB.getCalledFunction();
+  return Callee && Callee->getName() == "runtime_deallocate";
+}
+
+// Moves gc allocations of a constant size whose object provably does not
+// outlive the allocating function call to an alloca in addrspace 0, so they
+// no longer cost heap space, collections or stack map slots.
+//
+// An object does not escape if it is only loaded from, stored to, compared,
+// or passed to callees that do the same with it. Objects that a gc pointer
+// is stored into stay on the heap: nothing would trace them on the stack.
+// Must run before place-safepoints, rewrite-statepoints-for-gc and the
+// inlining of allocate.ll.
+class EscapeAnalysisPass : public PassInfoMixin<EscapeAnalysisPass> {
+public:
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) {
+    SmallVector<CallBase *, 16> Candidates;
+    for (Function &F : M) {
+      for (Instruction &I : instructions(F)) {
+        auto *CB = dyn_cast<CallBase>(&I);
+        if (CB && isAllocation(*CB) && isCandidate(*CB))
+          Candidates.push_back(CB);
+      }
+    }
+
+    for (CallBase *CB : Candidates)
+      promoteToStack(*CB, M.getDataLayout());
+
+    return Candidates.empty() ? PreservedAnalyses::all()
+                              : PreservedAnalyses::none();
+  }
+
+private:
+  bool isCandidate(CallBase &CB) {
+    auto *Size = dyn_cast<ConstantInt>(CB.getArgOperand(0));
+    if (!Size || Size->getZExtValue() > MaxStackObjectSize)
+      return false;
+    return !escapes(&CB, /*OwnsObject=*/true);
+  }
+
+  // With `OwnsObject`, V points to an object allocated in this function,
+  // which may release it.
+  bool escapes(Value *V, bool OwnsObject) {
+    for (Use &U : V->uses()) {
+      auto *I = cast<Instruction>(U.getUser());
+      switch (I->getOpcode()) {
+      case Instruction::BitCast:
+      case Instruction::AddrSpaceCast:
+      case Instruction::GetElementPtr:
+        if (escapes(I, OwnsObject))
+          return true;
+        break;
+      case Instruction::Load:
+        if (cast<LoadInst>(I)->isVolatile())
+          return true;
+        break;
+      case Instruction::Store: {
+        auto *SI = cast<StoreInst>(I);
+        if (U.getOperandNo() != SI->getPointerOperandIndex() ||
+            SI->isVolatile() ||
+            containsGCPointer(SI->getValueOperand()->getType()))
+          return true;
+        break;
+      }
+      case Instruction::ICmp:
+        break;
+      case Instruction::Call:
+      case Instruction::Invoke:
+        if (callEscapes(*cast<CallBase>(I), U, OwnsObject))
+          return true;
+        break;
+      default:
+        // returned, stored as a value, merged in a phi or select, ...
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool callEscapes(CallBase &CB, Use &U, bool OwnsObject) {
+    if (isDeallocation(CB))
+      return !OwnsObject;
+    if (auto *MS = dyn_cast<MemSetInst>(&CB))
+      return U.getOperandNo() != 0 || MS->isVolatile();
+    if (!CB.isArgOperand(&U))
+      return true;
+
+    unsigned ArgNo = CB.getArgOperandNo(&U);
+    Function *Callee = CB.getCalledFunction();
+    if (!Callee || Callee->isVarArg() || ArgNo >= Callee->arg_size())
+      return true;
+    if (is_contained(NonCapturingFunctions, Callee->getName()))
+      return false;
+    if (Callee->isDeclaration())
+      return !CB.paramHasAttr(ArgNo, Attribute::NoCapture) ||
+             !CB.onlyReadsMemory(ArgNo);
+    return argumentEscapes(Callee->getArg(ArgNo));
+  }
+
+  // Callee parameters are analysed like allocations, with recursive calls
+  // assumed to escape until proven otherwise.
+  bool argumentEscapes(Argument *Arg) {
+    auto [It, Inserted] = Arguments.try_emplace(Arg, true);
+    if (!Inserted)
+      return It->second;
+    bool Escapes = escapes(Arg, /*OwnsObject=*/false);
+    Arguments[Arg] = Escapes;
+    return Escapes;
+  }
+
+  void promoteToStack(CallBase &CB, const DataLayout &DL) {
+    uint64_t Size = cast<ConstantInt>(CB.getArgOperand(0))->getZExtValue();
+    Function &F = *CB.getFunction();
+    LLVMContext &Ctx = F.getContext();
+
+    IRBuilder<> Entry(&F.getEntryBlock(),
+                      F.getEntryBlock().getFirstInsertionPt());
+    AllocaInst *Slot =
+        Entry.CreateAlloca(ArrayType::get(Type::getInt8Ty(Ctx), Size),
+                           DL.getAllocaAddrSpace(), nullptr, "stack.obj");
+    Slot->setAlignment(Align(8));
+
+    // the runtime hands out zeroed objects, an alloca in a loop is reused
+    IRBuilder<> B(&CB);
+    B.CreateMemSet(Slot, B.getInt8(0), Size, Align(8));
+
+    rewriteUses(&CB, Slot, DL);
+    CB.eraseFromParent();
+
+    ++NumStackObjects;
+    NumStackBytes += Size;
+  }
+
+  // Replace `Old`, a gc pointer to the object, with `New` pointing into the
+  // alloca, moving every address computation to addrspace 0.
+  void rewriteUses(Value *Old, Value *New, const DataLayout &DL) {
+    for (Use &U : make_early_inc_range(Old->uses())) {
+      auto *I = cast<Instruction>(U.getUser());
+      IRBuilder<> B(I);
+      if (auto *GEP = dyn_cast<GetElementPtrInst>(I)) {
+        SmallVector<Value *, 4> Indices(GEP->indices());
+        Value *NewGEP = B.CreateGEP(GEP->getSourceElementType(), New, Indices,
+                                    GEP->getName(), GEP->isInBounds());
+        rewriteUses(GEP, NewGEP, DL);
+        GEP->eraseFromParent();
+      } else if (isa<BitCastInst, AddrSpaceCastInst>(I)) {
+        rewriteUses(I, New, DL);
+        I->eraseFromParent();
+      } else if (isa<LoadInst, StoreInst>(I)) {
+        U.set(New);
+      } else if (auto *CB = dyn_cast<CallBase>(I); CB && isDeallocation(*CB)) {
+        CB->eraseFromParent();
+      } else if (auto *MS = dyn_cast<MemSetInst>(I)) {
+        B.CreateMemSet(New, MS->getValue(), MS->getLength(),
+                       MS->getDestAlign());
+        MS->eraseFromParent();
+      } else {
+        // Compares and callees still take a gc pointer. It is made with
+        // inttoptr so rewrite-statepoints-for-gc takes it for a base
+        // pointer; the runtime leaves pointers outside its heap alone.
+        Value *Address =
+            B.CreatePtrToInt(New, DL.getIntPtrType(New->getType()));
+        U.set(B.CreateIntToPtr(Address, Old->getType()));
+      }
+    }
+  }
+
+private:
+  DenseMap<Argument *, bool> Arguments;
+};
+
+} // namespace
+
+extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo
+llvmGetPassPluginInfo() {
+  return {LLVM_PLUGIN_API_VERSION, "EscapeAnalysisPass", LLVM_VERSION_STRING,
+          [](PassBuilder &PB) {
+            PB.registerPipelineParsingCallback(
+                [](StringRef Name, ModulePassManager &MPM,
+                   ArrayRef<PassBuilder::PipelineElement>) {
+                  if (Name == DEBUG_TYPE) {
+                    MPM.addPass(EscapeAnalysisPass());
+                    return true;
+                  }
+                  return false;
+                });
+          }};
+}
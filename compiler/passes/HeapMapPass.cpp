@@ -1,3 +1,4 @@
+#include "HeapMapPass.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Module.h"
@@ -10,6 +11,7 @@
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/Debug.h>
 
 using namespace llvm;
 
@@ -25,47 +27,49 @@ struct HeapMapRecord {
 
 };
 
-class HeapMapPass : public PassInfoMixin<HeapMapPass> {
-public:
-  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) {
-    scanStructType(M);
-    return PreservedAnalyses::all();
-  }
+} // namespace
 
-  void scanStructType(Module &M) {
-    TypeFinder finder;
-    finder.run(M, false);
-    for (StructType *ST : finder) {
-      if (processStructType(ST, ST, M.getDataLayout(), 0)) {
-        ++NumHeapMaps;
-      }
-      ++NumStructScanned;
+namespace rx {
+
+PreservedAnalyses HeapMapPass::run(Module &M, ModuleAnalysisManager &MAM) {
+  scanStructType(M);
+  return PreservedAnalyses::all();
+}
+
+void HeapMapPass::scanStructType(Module &M) {
+  TypeFinder finder;
+  finder.run(M, false);
+  for (StructType *ST : finder) {
+    if (processStructType(ST, ST, M.getDataLayout(), 0)) {
+      ++NumHeapMaps;
     }
+    ++NumStructScanned;
   }
+}
 
-  bool processStructType(StructType* Root, StructType *ST, const DataLayout &DL,
-                         uint64_t CurrOffset) {
-    bool processed = false;
-    const auto *Layout = DL.getStructLayout(ST);
-    auto Offsets = Layout->getMemberOffsets();
-
-    ST->dump();
-    for (auto [Idx, T] : enumerate(ST->elements())) {
-      if (PointerType *Ptr = dyn_cast<PointerType>(T)) {
-        if (Ptr->getAddressSpace() == 1) {
-          processed = true;
-        }
-      }
-      if (StructType *NestedST = dyn_cast<StructType>(T)) {
-        processed |= processStructType(Root, NestedST, DL, Offsets[Idx]);
+bool HeapMapPass::processStructType(StructType *Root, StructType *ST,
+                                    const DataLayout &DL,
+                                    uint64_t CurrOffset) {
+  bool processed = false;
+  const auto *Layout = DL.getStructLayout(ST);
+  auto Offsets = Layout->getMemberOffsets();
+
+  LLVM_DEBUG(ST->dump());
+  for (auto [Idx, T] : enumerate(ST->elements())) {
+    if (PointerType *Ptr = dyn_cast<PointerType>(T)) {
+      if (Ptr->getAddressSpace() == 1) {
+        processed = true;
       }
     }
-
-    return processed;
+    if (StructType *NestedST = dyn_cast<StructType>(T)) {
+      processed |= processStructType(Root, NestedST, DL, Offsets[Idx]);
+    }
   }
-};
 
-} // namespace
+  return processed;
+}
+
+} // namespace rx
 
 extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo
 llvmGetPassPluginInfo() {
@@ -75,7 +79,7 @@ llvmGetPassPluginInfo() {
                 [](StringRef Name, ModulePassManager &MPM,
                    ArrayRef<PassBuilder::PipelineElement>) {
                   if (Name == DEBUG_TYPE) {
-                    MPM.addPass(HeapMapPass());
+                    MPM.addPass(rx::HeapMapPass());
                     return true;
                   }
                   return false;
@@ -0,0 +1,27 @@
+#ifndef RXC_PASSES_HEAPMAPPASS_H
+#define RXC_PASSES_HEAPMAPPASS_H
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+
+namespace rx {
+
+// Builds the heap maps of the struct types of a module. Besides the plugin
+// entry point in HeapMapPass.cpp, the frontend links the pass in and runs it
+// in-process as part of its pipeline.
+class HeapMapPass : public llvm::PassInfoMixin<HeapMapPass> {
+public:
+  llvm::PreservedAnalyses run(llvm::Module &M,
+                              llvm::ModuleAnalysisManager &MAM);
+
+private:
+  void scanStructType(llvm::Module &M);
+  bool processStructType(llvm::StructType *Root, llvm::StructType *ST,
+                         const llvm::DataLayout &DL, uint64_t CurrOffset);
+};
+
+} // namespace rx
+
+#endif
@@ -0,0 +1,235 @@
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace llvm;
+
+namespace {
+
+#define DEBUG_TYPE "gc-safepoint-opt"
+
+STATISTIC(NumLoopPolls, "Number of polls removed from counted loops");
+STATISTIC(NumMergedPolls, "Number of polls merged into an earlier one");
+STATISTIC(NumRematerialized, "Number of derived pointers rematerialized");
+
+cl::opt<bool> PollCountedLoops(
+    "gc-poll-counted-loops", cl::init(false),
+    cl::desc("Keep safepoint polls in counted loops that do not allocate"));
+
+cl::opt<unsigned> MaxUnpolledIterations(
+    "gc-poll-max-unpolled-iterations", cl::init(1024),
+    cl::desc("Most iterations, summed over a loop nest, that run without a "
+             "safepoint poll"));
+
+constexpr StringRef PollFunction = "runtime_gc_poll";
+
+constexpr StringRef AllocFunctions[] = {
+    "runtime_allocate", "runtime_allocate_typed", "runtime_allocate_inline",
+    "runtime_allocate_slow"};
+
+constexpr unsigned GCAddressSpace = 1;
+
+bool calls(const Instruction &I, ArrayRef<StringRef> Names) {
+  auto *CB = dyn_cast<CallBase>(&I);
+  if (!CB)
+    return false;
+  const Function *Callee = CB->getCalledFunction();
+  return Callee && is_contained(Names, Callee->getName());
+}
+
+bool isPoll(const Instruction &I) { return calls(I, PollFunction); }
+
+// Calls other than intrinsics may run for an unbounded time without polling.
+bool isOpaqueCall(const Instruction &I) {
+  return isa<CallBase>(I) && !isa<IntrinsicInst>(I);
+}
+
+// Reduces the safepoints placed by place-safepoints and the gc pointers
+// live across them, before rewrite-statepoints-for-gc turns both into stack
+// map entries:
+//  - bounded loops lose their backedge poll unless they allocate, as long
+//    as the iterations of the whole nest run without a poll stay below
+//    -gc-poll-max-unpolled-iterations. The bound is the constant maximum
+//    trip count, so time to safepoint never depends on the input: a loop to
+//    an argument keeps its poll, and one of the loops of a deep nest of
+//    small loops does
+//  - a poll that follows another poll with only straight-line code in
+//    between is dropped
+//  - derived pointers with constant offsets are recomputed from their base
+//    right before each use past a call, so only the base needs a slot
+class SafepointPass : public PassInfoMixin<SafepointPass> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM) {
+    if (!F.hasGC() || F.isDeclaration())
+      return PreservedAnalyses::all();
+
+    auto &LI = FAM.getResult<LoopAnalysis>(F);
+    auto &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+
+    bool Changed = false;
+    DenseMap<const Loop *, uint64_t> Unpolled;
+    // inner loops first, the trip counts of the outer ones multiply theirs
+    for (Loop *L : reverse(LI.getLoopsInPreorder()))
+      Changed |= removeCountedLoopPolls(*L, LI, SE, Unpolled);
+    Changed |= mergeAdjacentPolls(F);
+    Changed |= rematerializeDerivedPointers(F);
+
+    if (!Changed)
+      return PreservedAnalyses::all();
+    PreservedAnalyses PA;
+    PA.preserveSet<CFGAnalyses>();
+    return PA;
+  }
+
+private:
+  // Unpolled holds, for the loops that lost their poll, how many iterations
+  // of the loop and the loops nested in it can run before the next poll.
+  bool removeCountedLoopPolls(Loop &L, LoopInfo &LI, ScalarEvolution &SE,
+                              DenseMap<const Loop *, uint64_t> &Unpolled) {
+    if (PollCountedLoops)
+      return false;
+    uint64_t Iterations = SE.getSmallConstantMaxTripCount(&L);
+    if (!Iterations)
+      return false;
+    uint64_t Inner = 1;
+    for (const Loop *Sub : L.getSubLoops())
+      Inner = std::max(Inner, Unpolled.lookup(Sub));
+    // both factors fit in 32 bits
+    Iterations *= Inner;
+    if (Iterations > MaxUnpolledIterations)
+      return false;
+
+    SmallVector<Instruction *, 4> Polls;
+    for (BasicBlock *BB : L.blocks()) {
+      for (Instruction &I : *BB) {
+        if (calls(I, AllocFunctions))
+          return false;
+        // inner loops keep their own polls
+        if (isPoll(I) && LI.getLoopFor(BB) == &L)
+          Polls.push_back(&I);
+      }
+    }
+
+    for (Instruction *Poll : Polls)
+      Poll->eraseFromParent();
+    NumLoopPolls += Polls.size();
+    Unpolled[&L] = Iterations;
+    return !Polls.empty();
+  }
+
+  // Whether an earlier poll is reached on every path to `Poll` through
+  // straight-line code, i.e. without an opaque call or a merge point.
+  bool followsPoll(Instruction &Poll) {
+    SmallPtrSet<BasicBlock *, 8> Visited;
+    BasicBlock *BB = Poll.getParent();
+    auto It = Poll.getReverseIterator();
+    ++It;
+    while (Visited.insert(BB).second) {
+      for (; It != BB->rend(); ++It) {
+        if (isPoll(*It))
+          return true;
+        if (isOpaqueCall(*It))
+          return false;
+      }
+      BB = BB->getSinglePredecessor();
+      if (!BB)
+        return false;
+      It = BB->rbegin();
+    }
+    return false;
+  }
+
+  bool mergeAdjacentPolls(Function &F) {
+    SmallVector<Instruction *, 8> Redundant;
+    for (Instruction &I : instructions(F)) {
+      if (isPoll(I) && followsPoll(I))
+        Redundant.push_back(&I);
+    }
+
+    // erasing a later poll never changes whether an earlier one follows a
+    // poll, the first poll of a chain always stays
+    for (Instruction *Poll : Redundant)
+      Poll->eraseFromParent();
+    NumMergedPolls += Redundant.size();
+    return !Redundant.empty();
+  }
+
+  static bool isDerivedPointer(const Instruction &I) {
+    auto *GEP = dyn_cast<GetElementPtrInst>(&I);
+    return GEP && GEP->getType()->isPointerTy() &&
+           GEP->getType()->getPointerAddressSpace() == GCAddressSpace &&
+           GEP->hasAllConstantIndices();
+  }
+
+  static bool opaqueCallBetween(Instruction *From, Instruction *To) {
+    for (Instruction *I = From->getNextNode(); I && I != To;
+         I = I->getNextNode()) {
+      if (isOpaqueCall(*I))
+        return true;
+    }
+    return false;
+  }
+
+  bool rematerializeDerivedPointers(Function &F) {
+    SmallVector<Instruction *, 16> Derived;
+    for (Instruction &I : instructions(F)) {
+      if (isDerivedPointer(I))
+        Derived.push_back(&I);
+    }
+
+    // Outer GEPs first, so their copies become uses of the inner ones and
+    // whole chains move next to their uses.
+    bool Changed = false;
+    for (Instruction *GEP : reverse(Derived)) {
+      for (Use &U : make_early_inc_range(GEP->uses())) {
+        auto *User = cast<Instruction>(U.getUser());
+        Instruction *InsertPt = User;
+        if (auto *Phi = dyn_cast<PHINode>(User))
+          InsertPt = Phi->getIncomingBlock(U)->getTerminator();
+        if (InsertPt->getParent() == GEP->getParent() &&
+            !opaqueCallBetween(GEP, InsertPt))
+          continue;
+
+        Instruction *Copy = GEP->clone();
+        Copy->setName(GEP->getName() + ".remat");
+        Copy->insertBefore(InsertPt);
+        U.set(Copy);
+        ++NumRematerialized;
+        Changed = true;
+      }
+      if (GEP->use_empty())
+        GEP->eraseFromParent();
+    }
+    return Changed;
+  }
+};
+
+} // namespace
+
+extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo
+llvmGetPassPluginInfo() {
+  return {LLVM_PLUGIN_API_VERSION, "SafepointPass", LLVM_VERSION_STRING,
+          [](PassBuilder &PB) {
+            PB.registerPipelineParsingCallback(
+                [](StringRef Name, FunctionPassManager &FPM,
+                   ArrayRef<PassBuilder::PipelineElement>) {
+                  if (Name == DEBUG_TYPE) {
+                    FPM.addPass(SafepointPass());
+                    return true;
+                  }
+                  return false;
+                });
+          }};
+}
@@ -0,0 +1,126 @@
+; RUN: opt -load-pass-plugin=%passes/EscapeAnalysisPass.so -passes=gc-escape -S %s | FileCheck %s
+
+declare ptr addrspace(1) @runtime_allocate(i64)
+declare ptr addrspace(1) @runtime_allocate_typed(i64, i32)
+declare void @runtime_deallocate(ptr addrspace(1))
+declare void @runtime_inspect_ptr(ptr addrspace(1))
+declare void @unknown(ptr addrspace(1))
+
+@global = global ptr addrspace(1) null
+
+define i32 @add(ptr addrspace(1) %a, ptr addrspace(1) %b) gc "statepoint-example" {
+entry:
+    %x = load i32, ptr addrspace(1) %a
+    %y = load i32, ptr addrspace(1) %b
+    %sum = add i32 %x, %y
+    ret i32 %sum
+}
+
+define void @other(ptr addrspace(1) %ptr) gc "statepoint-example" {
+entry:
+    call void @runtime_inspect_ptr(ptr addrspace(1) %ptr)
+    ret void
+}
+
+; The temporaries of runtime/main.ll move to the stack.
+; CHECK-LABEL: define i32 @test(
+; CHECK-DAG: %stack.obj = alloca [4 x i8], align 8
+; CHECK-DAG: %stack.obj1 = alloca [4 x i8], align 8
+; CHECK-NOT: @runtime_allocate
+; CHECK: store i32 123, ptr %stack.obj
+; CHECK: call i32 @add(ptr addrspace(1)
+; CHECK: ret i32
+define i32 @test() gc "statepoint-example" {
+entry:
+    %a = call ptr addrspace(1) @runtime_allocate(i64 4)
+    %b = call ptr addrspace(1) @runtime_allocate(i64 4)
+    store i32 123, ptr addrspace(1) %a
+    store i32 456, ptr addrspace(1) %b
+    %sum = call i32 @add(ptr addrspace(1) %a, ptr addrspace(1) %b)
+    call void @other(ptr addrspace(1) %b)
+    ret i32 %sum
+}
+
+; Released objects lose their runtime_deallocate call as well.
+; CHECK-LABEL: define i64 @released(
+; CHECK: alloca [16 x i8]
+; CHECK-NOT: @runtime_deallocate
+define i64 @released() gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate_typed(i64 16, i32 0)
+    %field = getelementptr i64, ptr addrspace(1) %obj, i64 1
+    store i64 7, ptr addrspace(1) %field
+    %value = load i64, ptr addrspace(1) %field
+    call void @runtime_deallocate(ptr addrspace(1) %obj)
+    ret i64 %value
+}
+
+; CHECK-LABEL: define ptr addrspace(1) @returned(
+; CHECK: call ptr addrspace(1) @runtime_allocate(i64 8)
+define ptr addrspace(1) @returned() gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 8)
+    ret ptr addrspace(1) %obj
+}
+
+; CHECK-LABEL: define void @stored(
+; CHECK: call ptr addrspace(1) @runtime_allocate(i64 8)
+define void @stored() gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 8)
+    store ptr addrspace(1) %obj, ptr @global
+    ret void
+}
+
+; Nothing would trace a gc pointer kept in a stack object.
+; CHECK-LABEL: define void @holds_pointer(
+; CHECK: call ptr addrspace(1) @runtime_allocate(i64 8)
+define void @holds_pointer(ptr addrspace(1) %other) gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 8)
+    store ptr addrspace(1) %other, ptr addrspace(1) %obj
+    ret void
+}
+
+; CHECK-LABEL: define void @unknown_callee(
+; CHECK: call ptr addrspace(1) @runtime_allocate(i64 8)
+define void @unknown_callee() gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 8)
+    call void @unknown(ptr addrspace(1) %obj)
+    ret void
+}
+
+; CHECK-LABEL: define void @too_big(
+; CHECK: call ptr addrspace(1) @runtime_allocate(i64 4096)
+define void @too_big() gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 4096)
+    store i8 1, ptr addrspace(1) %obj
+    ret void
+}
+
+; A stack object in a loop is zeroed on every iteration.
+; CHECK-LABEL: define i32 @loop(
+; CHECK: entry:
+; CHECK-NEXT: %stack.obj = alloca [4 x i8], align 8
+; CHECK: body:
+; CHECK: call void @llvm.memset.p0.i64(ptr align 8 %stack.obj, i8 0, i64 4, i1 false)
+define i32 @loop(i32 %n) gc "statepoint-example" {
+entry:
+    br label %body
+
+body:
+    %i = phi i32 [ 0, %entry ], [ %next, %body ]
+    %acc = phi i32 [ 0, %entry ], [ %sum, %body ]
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 4)
+    %old = load i32, ptr addrspace(1) %obj
+    store i32 %i, ptr addrspace(1) %obj
+    %sum = add i32 %acc, %old
+    %next = add i32 %i, 1
+    %done = icmp eq i32 %next, %n
+    br i1 %done, label %exit, label %body
+
+exit:
+    ret i32 %sum
+}
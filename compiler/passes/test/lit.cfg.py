@@ -0,0 +1,10 @@
+import lit.formats
+
+config.name = 'Passes Test'
+config.test_format = lit.formats.ShTest(True)
+config.suffixes = ['.ll']
+config.excludes = ['linked.ll']
+config.test_source_root = os.path.dirname(__file__)
+config.test_exec_root = config.test_source_root
+
+config.substitutions.append(('%passes', os.environ.get('PASSES_DIR', '')))
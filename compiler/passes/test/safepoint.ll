@@ -0,0 +1,174 @@
+; RUN: opt -load-pass-plugin=%passes/SafepointPass.so -passes='function(gc-safepoint-opt)' -S %s | FileCheck %s
+
+declare void @runtime_gc_poll()
+declare ptr addrspace(1) @runtime_allocate(i64)
+declare void @consume(ptr addrspace(1))
+
+; Bounded loops that do not allocate run without a backedge poll.
+; CHECK-LABEL: define i64 @sum(
+; CHECK: entry:
+; CHECK-NEXT: call void @runtime_gc_poll()
+; CHECK: loop:
+; CHECK-NOT: call void @runtime_gc_poll()
+; CHECK: exit:
+define i64 @sum(ptr addrspace(1) %array) gc "statepoint-example" {
+entry:
+    call void @runtime_gc_poll()
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %next, %loop ]
+    %acc = phi i64 [ 0, %entry ], [ %sum, %loop ]
+    %elem = getelementptr i64, ptr addrspace(1) %array, i64 %i
+    %value = load i64, ptr addrspace(1) %elem
+    %sum = add i64 %acc, %value
+    %next = add i64 %i, 1
+    call void @runtime_gc_poll()
+    %done = icmp eq i64 %next, 256
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret i64 %sum
+}
+
+; A loop bounded by an argument runs for as long as its input says and
+; keeps its poll.
+; CHECK-LABEL: define i64 @sum_n(
+; CHECK: loop:
+; CHECK: call void @runtime_gc_poll()
+; CHECK: exit:
+define i64 @sum_n(ptr addrspace(1) %array, i64 %n) gc "statepoint-example" {
+entry:
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %next, %loop ]
+    %acc = phi i64 [ 0, %entry ], [ %sum, %loop ]
+    %elem = getelementptr i64, ptr addrspace(1) %array, i64 %i
+    %value = load i64, ptr addrspace(1) %elem
+    %sum = add i64 %acc, %value
+    %next = add i64 %i, 1
+    call void @runtime_gc_poll()
+    %done = icmp eq i64 %next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret i64 %sum
+}
+
+; Nested bounded loops count together: the inner loop of 100 iterations
+; loses its poll, the outer loop would make 10000 without one and keeps it.
+; CHECK-LABEL: define void @nested(
+; CHECK: inner:
+; CHECK-NOT: call void @runtime_gc_poll()
+; CHECK: latch:
+; CHECK-NEXT: call void @runtime_gc_poll()
+define void @nested(ptr addrspace(1) %array) gc "statepoint-example" {
+entry:
+    br label %outer
+
+outer:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+    br label %inner
+
+inner:
+    %j = phi i64 [ 0, %outer ], [ %j.next, %inner ]
+    %elem = getelementptr i64, ptr addrspace(1) %array, i64 %j
+    store i64 %i, ptr addrspace(1) %elem
+    %j.next = add i64 %j, 1
+    call void @runtime_gc_poll()
+    %inner.done = icmp eq i64 %j.next, 100
+    br i1 %inner.done, label %latch, label %inner
+
+latch:
+    call void @runtime_gc_poll()
+    %i.next = add i64 %i, 1
+    %outer.done = icmp eq i64 %i.next, 100
+    br i1 %outer.done, label %exit, label %outer
+
+exit:
+    ret void
+}
+
+; CHECK-LABEL: define void @allocating(
+; CHECK: loop:
+; CHECK: call void @runtime_gc_poll()
+define void @allocating(i64 %n) gc "statepoint-example" {
+entry:
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %next, %loop ]
+    %obj = call ptr addrspace(1) @runtime_allocate(i64 16)
+    %next = add i64 %i, 1
+    call void @runtime_gc_poll()
+    %done = icmp eq i64 %next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret void
+}
+
+; A list walk has no trip count and keeps its poll.
+; CHECK-LABEL: define i64 @length(
+; CHECK: loop:
+; CHECK: call void @runtime_gc_poll()
+define i64 @length(ptr addrspace(1) %head) gc "statepoint-example" {
+entry:
+    br label %loop
+
+loop:
+    %node = phi ptr addrspace(1) [ %head, %entry ], [ %next, %loop ]
+    %count = phi i64 [ 0, %entry ], [ %inc, %loop ]
+    %inc = add i64 %count, 1
+    %link = getelementptr i8, ptr addrspace(1) %node, i64 8
+    %next = load ptr addrspace(1), ptr addrspace(1) %link
+    call void @runtime_gc_poll()
+    %end = icmp eq ptr addrspace(1) %next, null
+    br i1 %end, label %exit, label %loop
+
+exit:
+    ret i64 %inc
+}
+
+; Polls with only straight-line code between them collapse into the first.
+; CHECK-LABEL: define void @adjacent(
+; CHECK: call void @runtime_gc_poll()
+; CHECK-NOT: call void @runtime_gc_poll()
+; CHECK: call void @consume(
+; CHECK-NEXT: call void @runtime_gc_poll()
+; CHECK-NOT: call void @runtime_gc_poll()
+; CHECK: ret void
+define void @adjacent(ptr addrspace(1) %obj, i1 %flag) gc "statepoint-example" {
+entry:
+    call void @runtime_gc_poll()
+    call void @runtime_gc_poll()
+    br label %next
+
+next:
+    call void @runtime_gc_poll()
+    call void @consume(ptr addrspace(1) %obj)
+    call void @runtime_gc_poll()
+    br i1 %flag, label %then, label %done
+
+then:
+    call void @runtime_gc_poll()
+    br label %done
+
+done:
+    ret void
+}
+
+; Derived pointers are recomputed after the call instead of living across it.
+; CHECK-LABEL: define i32 @derived(
+; CHECK: call void @consume(ptr addrspace(1) %obj)
+; CHECK-NEXT: %field.remat = getelementptr i8, ptr addrspace(1) %obj, i64 12
+; CHECK-NEXT: load i32, ptr addrspace(1) %field.remat
+define i32 @derived(ptr addrspace(1) %obj) gc "statepoint-example" {
+entry:
+    %field = getelementptr i8, ptr addrspace(1) %obj, i64 12
+    store i32 1, ptr addrspace(1) %field
+    call void @consume(ptr addrspace(1) %obj)
+    %value = load i32, ptr addrspace(1) %field
+    ret i32 %value
+}
@@ -3,6 +3,9 @@
 #include "rxc/AST/TypeContext.h"
 #include "rxc/Basic/Diagnostic.h"
 #include "rxc/Basic/SourceManager.h"
+#include "rxc/CodeGen/Backend.h"
+#include "rxc/CodeGen/CodeGenModule.h"
+#include "rxc/CodeGen/JIT.h"
 #include "rxc/Frontend/TranslationUnitContext.h"
 #include "rxc/Sema/LexicalContext.h"
 #include "rxc/Sema/LexicalScope.h"
@@ -13,12 +16,15 @@
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/SCCIterator.h>
 #include <llvm/ADT/SmallString.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
 #include <llvm/Support/DOTGraphTraits.h>
 #include <llvm/Support/ErrorHandling.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/GraphWriter.h>
 #include <llvm/Support/InitLLVM.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Support/raw_ostream.h>
 
@@ -35,6 +41,25 @@ static cl::opt<std::string>
     InputFile("src", cl::Positional, cl::value_desc("input file"),
               cl::desc("Source file to pass to the compiler frontend"));
 
+static cl::opt<std::string>
+    OutputFile("o", cl::value_desc("filename"),
+               cl::desc("Lower the program and write an object file, or "
+                        "textual IR with -emit-llvm, to <filename>"));
+static cl::opt<unsigned> OptLevel("O", cl::Prefix, cl::init(2),
+                                  cl::value_desc("level"),
+                                  cl::desc("Optimization level 0 to 3"));
+static cl::opt<unsigned>
+    Jobs("j", cl::Prefix, cl::init(1), cl::value_desc("partitions"),
+         cl::desc("Split the program into <partitions> modules compiled in "
+                  "parallel, the output is a static archive of their "
+                  "objects"));
+static cl::opt<bool> JIT("jit", cl::Optional, cl::init(false),
+                         cl::desc("Run the program in-process and exit with "
+                                  "its exit code"));
+static cl::opt<bool> EmitLLVM("emit-llvm", cl::Optional, cl::init(false),
+                              cl::desc("Write the lowered IR instead of an "
+                                       "object file"));
+
 static cl::opt<bool> Debug("debug", cl::Optional, cl::init(false),
                            cl::desc("Enable debugging"));
 static cl::opt<bool> DebugSemaManager("debug-sema-manager", cl::Optional,
@@ -92,8 +117,75 @@ static void populateBuiltins(ASTContext &GlobalASTContext,
           GlobalASTContext.createNode<ASTBuiltinType>(ASTNativeType::String)));
 }
 
+// Lowers the type checked translation units, imports first, into one module
+// and writes it to OutputFile, or runs it with -jit. Returns the exit code.
+static int compileProgram(ArrayRef<TranslationUnit *> Order,
+                          TranslationUnit *RootTU, DiagnosticConsumer &DC,
+                          LexicalContext &LC, TypeContext &TC) {
+  codegen::BackendOptions Opts;
+  Opts.OptLevel = std::min(OptLevel.getValue(), 3u);
+  Opts.Partitions = std::max(Jobs.getValue(), 1u);
+
+  std::string Error;
+  auto TM = codegen::createHostTargetMachine(Opts, Error);
+  if (!TM) {
+    llvm::WithColor::error(llvm::errs(), "rx-frontend") << Error << "\n";
+    return 1;
+  }
+
+  auto Ctx = std::make_unique<LLVMContext>();
+  codegen::CodeGenModule CGM(*Ctx, InputFile, TM->createDataLayout(),
+                             TM->getTargetTriple().str(), DC, LC, TC);
+  for (auto *TU : Order)
+    CGM.addProgram(TU->getProgramAST());
+  auto M = CGM.generate(RootTU->getProgramAST());
+  if (!M)
+    return 1;
+
+  if (JIT) {
+    auto RC = codegen::runInJIT(
+        orc::ThreadSafeModule(std::move(M), std::move(Ctx)), Opts);
+    if (!RC) {
+      logAllUnhandledErrors(RC.takeError(),
+                            llvm::WithColor::error(llvm::errs(), "rx-frontend"));
+      return 1;
+    }
+    return *RC;
+  }
+
+  std::error_code EC;
+  ToolOutputFile Out(OutputFile, EC,
+                     EmitLLVM ? sys::fs::OF_Text : sys::fs::OF_None);
+  if (EC) {
+    llvm::WithColor::error(llvm::errs(), "rx-frontend")
+        << OutputFile << ": " << EC.message() << "\n";
+    return 1;
+  }
+
+  if (Opts.Partitions > 1 && !EmitLLVM) {
+    if (!codegen::emitObjectArchive(*M, Opts, Out.os(), Error)) {
+      llvm::WithColor::error(llvm::errs(), "rx-frontend") << Error << "\n";
+      return 1;
+    }
+    Out.keep();
+    return 0;
+  }
+
+  codegen::optimizeModule(*M, *TM, Opts);
+  if (EmitLLVM) {
+    M->print(Out.os(), nullptr);
+  } else if (!codegen::emitObjectFile(*M, *TM, Out.os(), Error)) {
+    llvm::WithColor::error(llvm::errs(), "rx-frontend") << Error << "\n";
+    return 1;
+  }
+  Out.keep();
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   InitLLVM X(argc, argv);
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
 
   cl::ParseCommandLineOptions(argc, argv, "rx-frontend command line options");
 
@@ -179,5 +271,9 @@ int main(int argc, char *argv[]) {
                        "Translation Unit Dependence Graph");
   }
 
-  return 0;
+  if (OutputFile.empty() && !JIT)
+    return 0;
+  if (CDC.getNumErrors())
+    return 1;
+  return compileProgram(BestEffortVisitOrder, RootTU, CDC, LC, TC);
 }
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "rxc/AST/AST.h"
+#include "rxc/Sema/ConstantEvaluator.h"
+
+using namespace rx;
+using namespace rx::ast;
+using rx::sema::ConstantEvaluator;
+
+namespace {
+
+const SourceLocation Loc = SourceLocation::Builtin();
+
+// Types and folds E as type checking does once its operands are folded.
+template <class T> T *fold(T *E, QualType Ty) {
+  E->setExprType(Ty);
+  E->setConstantValue(ConstantEvaluator::evaluate(E));
+  return E;
+}
+
+NumLiteral *number(double Value, QualType Ty) {
+  return fold(new NumLiteral(Loc, llvm::APFloat(Value)), Ty);
+}
+
+} // namespace
+
+TEST(ConstantEvaluatorTest, IntegerArithmetic) {
+  TypeContext Context;
+  auto I8 = Context.getBuiltinType(NativeType::i8);
+
+  auto *Mult = fold(new BinaryExpr(Loc, BinaryOp::Mult, number(100, I8),
+                                   number(3, I8)),
+                    I8);
+  ASSERT_NE(Mult->getConstantValue(), nullptr);
+  // wraps like the mul codegen emits
+  EXPECT_EQ(Mult->getConstantValue()->getInt().getSExtValue(), 44);
+
+  auto *Div = fold(new BinaryExpr(Loc, BinaryOp::Div, number(-7, I8),
+                                  number(2, I8)),
+                   I8);
+  ASSERT_NE(Div->getConstantValue(), nullptr);
+  EXPECT_EQ(Div->getConstantValue()->getInt().getSExtValue(), -3);
+
+  auto *Neg = fold(new UnaryExpr(Loc, UnaryOp::Negative, Div), I8);
+  ASSERT_NE(Neg->getConstantValue(), nullptr);
+  EXPECT_EQ(Neg->getConstantValue()->getInt().getSExtValue(), 3);
+}
+
+TEST(ConstantEvaluatorTest, DivisionByZero) {
+  TypeContext Context;
+  auto I32 = Context.getBuiltinType(NativeType::i32);
+
+  auto *Div = fold(new BinaryExpr(Loc, BinaryOp::Div, number(1, I32),
+                                  number(0, I32)),
+                   I32);
+  EXPECT_EQ(Div->getConstantValue(), nullptr);
+
+  // nothing folds above a value left to run time
+  auto *Add =
+      fold(new BinaryExpr(Loc, BinaryOp::Add, Div, number(1, I32)), I32);
+  EXPECT_EQ(Add->getConstantValue(), nullptr);
+}
+
+TEST(ConstantEvaluatorTest, Comparisons) {
+  TypeContext Context;
+  auto I1 = Context.getBuiltinType(NativeType::i1);
+  auto I64 = Context.getBuiltinType(NativeType::i64);
+  auto F64 = Context.getBuiltinType(NativeType::f64);
+
+  auto *Less = fold(new BinaryExpr(Loc, BinaryOp::Less, number(-1, I64),
+                                   number(1, I64)),
+                    I1);
+  ASSERT_NE(Less->getConstantValue(), nullptr);
+  EXPECT_TRUE(Less->getConstantValue()->getBool());
+
+  auto *Not = fold(new UnaryExpr(Loc, UnaryOp::Not, Less), I1);
+  ASSERT_NE(Not->getConstantValue(), nullptr);
+  EXPECT_FALSE(Not->getConstantValue()->getBool());
+
+  auto *NaN = fold(new BinaryExpr(Loc, BinaryOp::Div, number(0, F64),
+                                  number(0, F64)),
+                   F64);
+  ASSERT_NE(NaN->getConstantValue(), nullptr);
+  EXPECT_TRUE(NaN->getConstantValue()->getFloat().isNaN());
+
+  // only != is true for unordered operands
+  auto *Equal = fold(new BinaryExpr(Loc, BinaryOp::CmpEqual, NaN, NaN), I1);
+  auto *NotEqual =
+      fold(new BinaryExpr(Loc, BinaryOp::CmpNotEqual, NaN, NaN), I1);
+  EXPECT_FALSE(Equal->getConstantValue()->getBool());
+  EXPECT_TRUE(NotEqual->getConstantValue()->getBool());
+}
+
+TEST(ConstantEvaluatorTest, Literals) {
+  TypeContext Context;
+  auto F32 = Context.getBuiltinType(NativeType::f32);
+  auto I16 = Context.getBuiltinType(NativeType::i16);
+
+  const ConstantValue *Real = number(0.5, F32)->getConstantValue();
+  ASSERT_NE(Real, nullptr);
+  ASSERT_TRUE(Real->isFloat());
+  EXPECT_EQ(&Real->getFloat().getSemantics(), &llvm::APFloat::IEEEsingle());
+
+  const ConstantValue *Int = number(7, I16)->getConstantValue();
+  ASSERT_NE(Int, nullptr);
+  EXPECT_EQ(Int->getInt().getBitWidth(), 16u);
+
+  auto *C = fold(new CharLiteral(Loc, 'a'),
+                 Context.getBuiltinType(NativeType::i8));
+  EXPECT_EQ(C->getConstantValue()->getInt().getZExtValue(), 97u);
+
+  auto *S = fold(new ast::StringLiteral(Loc, "a"),
+                 Context.getBuiltinType(NativeType::string));
+  EXPECT_EQ(S->getConstantValue(), nullptr);
+}
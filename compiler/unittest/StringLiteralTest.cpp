@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "rxc/AST/TypeContext.h"
+#include "rxc/Basic/Diagnostic.h"
+#include "rxc/CodeGen/CodeGenModule.h"
+#include "rxc/Sema/LexicalContext.h"
+
+#include "object_header.h"
+#include "string_object.h"
+
+#include <llvm/ADT/APInt.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/LLVMContext.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace rx;
+
+namespace {
+
+// Literals are read by the runtime in place, so they are checked here with
+// its own accessors instead of against the bytes codegen is expected to emit.
+class StringLiteralTest : public ::testing::Test {
+protected:
+  // The object a literal points into, copied to 8 byte aligned storage as
+  // the global is, and the offset of the value in it.
+  struct Object {
+    std::vector<uint64_t> Words;
+    uint64_t Offset = 0;
+
+    const object_metadata &header() const {
+      return *reinterpret_cast<const object_metadata *>(payload() -
+                                                        sizeof(object_metadata));
+    }
+    const char *payload() const {
+      return reinterpret_cast<const char *>(Words.data()) + Offset;
+    }
+  };
+
+  Object emit(llvm::StringRef Value) {
+    llvm::Constant *C = CGM.emitStringLiteral(Value);
+    llvm::APInt Offset(64, 0);
+    const llvm::Value *Base = C->stripAndAccumulateInBoundsConstantOffsets(
+        CGM.getModule().getDataLayout(), Offset);
+    auto *G = llvm::cast<llvm::GlobalVariable>(Base);
+    llvm::StringRef Bytes =
+        llvm::cast<llvm::ConstantDataSequential>(G->getInitializer())
+            ->getRawDataValues();
+
+    Object O;
+    O.Words.resize((Bytes.size() + 7) / 8);
+    std::memcpy(O.Words.data(), Bytes.data(), Bytes.size());
+    O.Offset = Offset.getZExtValue();
+    return O;
+  }
+
+  llvm::LLVMContext Ctx;
+  ConsoleDiagnosticConsumer DC;
+  sema::LexicalContext LC;
+  TypeContext TC;
+  codegen::CodeGenModule CGM{Ctx, "test", llvm::DataLayout(""), "", DC, LC, TC};
+};
+
+} // namespace
+
+TEST_F(StringLiteralTest, ShortForm) {
+  Object O = emit("hello");
+  ASSERT_EQ(O.Offset, sizeof(object_metadata));
+  EXPECT_EQ(O.header().flags, object_static);
+  EXPECT_EQ(O.header().granules, str::kShortSize / 8);
+  EXPECT_EQ(O.header().type, 0u);
+
+  EXPECT_TRUE(str::is_short(O.payload()));
+  EXPECT_EQ(str::length(O.payload()), 5u);
+  EXPECT_STREQ(str::data(O.payload()), "hello");
+}
+
+TEST_F(StringLiteralTest, LongestShortForm) {
+  std::string Value(str::kMaxShortLength, 'x');
+  Object O = emit(Value);
+  EXPECT_TRUE(str::is_short(O.payload()));
+  EXPECT_EQ(str::length(O.payload()), Value.size());
+  EXPECT_EQ(str::data(O.payload()), Value);
+}
+
+TEST_F(StringLiteralTest, LongForm) {
+  std::string Value(str::kMaxShortLength + 1, 'y');
+  Object O = emit(Value);
+  ASSERT_EQ(O.Offset, sizeof(object_metadata));
+  EXPECT_EQ(O.header().flags, object_static);
+  EXPECT_EQ(O.header().granules * 8u,
+            (str::payload_size(Value.size()) + 7) / 8 * 8);
+
+  EXPECT_FALSE(str::is_short(O.payload()));
+  EXPECT_EQ(str::length(O.payload()), Value.size());
+  EXPECT_EQ(str::data(O.payload()), Value);
+}
+
+TEST_F(StringLiteralTest, EqualLiteralsShareAnObject) {
+  EXPECT_EQ(CGM.emitStringLiteral("abc"), CGM.emitStringLiteral("abc"));
+  EXPECT_NE(CGM.emitStringLiteral("abc"), CGM.emitStringLiteral("abd"));
+}
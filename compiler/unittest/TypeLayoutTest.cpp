@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include "rxc/AST/TypeContext.h"
+
+using namespace rx;
+
+TEST(TypeLayoutTest, ReordersByAlignment) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Fields;
+  Fields.insert({"flag", Context.getBuiltinType(NativeType::i1)});
+  Fields.insert({"count", Context.getBuiltinType(NativeType::i64)});
+  Fields.insert({"ratio", Context.getBuiltinType(NativeType::f32)});
+  Fields.insert({"code", Context.getBuiltinType(NativeType::i16)});
+  auto *Obj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Fields)).getType());
+
+  const ObjectLayout *Layout = Context.getObjectLayout(Obj);
+  ASSERT_NE(Layout, nullptr);
+  // in declaration order with natural alignment this would be 24 bytes
+  EXPECT_EQ(Layout->getSize(), 16u);
+  EXPECT_EQ(Layout->getAlignment(), 8u);
+  EXPECT_EQ(Layout->getNumGCPointers(), 0u);
+  EXPECT_EQ(Layout->getGCPointersEnd(), 0u);
+
+  auto Order = Layout->getFields();
+  ASSERT_EQ(Order.size(), 4u);
+  EXPECT_EQ(Order[0].Name, "count");
+  EXPECT_EQ(Order[0].Offset, 0u);
+  EXPECT_EQ(Order[1].Name, "ratio");
+  EXPECT_EQ(Order[1].Offset, 8u);
+  EXPECT_EQ(Order[2].Name, "code");
+  EXPECT_EQ(Order[2].Offset, 12u);
+  EXPECT_EQ(Order[3].Name, "flag");
+  EXPECT_EQ(Order[3].Offset, 14u);
+}
+
+TEST(TypeLayoutTest, GroupsGCPointers) {
+  TypeContext Context;
+  auto I32 = Context.getBuiltinType(NativeType::i32);
+
+  llvm::StringMap<QualType> Fields;
+  Fields.insert({"a", I32});
+  Fields.insert({"name", Context.getBuiltinType(NativeType::string)});
+  Fields.insert({"b", I32});
+  Fields.insert({"items", Context.getArrayType(I32)});
+  Fields.insert({"c", Context.getBuiltinType(NativeType::i8)});
+  auto *Obj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Fields)).getType());
+
+  const ObjectLayout *Layout = Context.getObjectLayout(Obj);
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getNumGCPointers(), 2u);
+  EXPECT_EQ(Layout->getGCPointersEnd(), 16u);
+  EXPECT_EQ(Layout->getSize(), 32u);
+
+  const FieldLayout *Items = Layout->getField("items");
+  const FieldLayout *Name = Layout->getField("name");
+  ASSERT_NE(Items, nullptr);
+  ASSERT_NE(Name, nullptr);
+  EXPECT_TRUE(Items->IsGCPointer);
+  EXPECT_EQ(Items->Offset, 0u);
+  EXPECT_EQ(Name->Offset, 8u);
+  EXPECT_EQ(Layout->getField("a")->Offset, 16u);
+  EXPECT_EQ(Layout->getField("c")->Offset, 24u);
+  EXPECT_EQ(Layout->getField("missing"), nullptr);
+}
+
+TEST(TypeLayoutTest, Cached) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Fields;
+  Fields.insert({"x", Context.getBuiltinType(NativeType::f64)});
+  auto *Obj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Fields)).getType());
+
+  EXPECT_EQ(Context.getObjectLayout(Obj), Context.getObjectLayout(Obj));
+}
+
+TEST(TypeLayoutTest, NoStorage) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Fields;
+  Fields.insert({"f", Context.getFuncType({}, Context.getUnitType())});
+  auto *Obj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Fields)).getType());
+
+  EXPECT_EQ(Context.getObjectLayout(Obj), nullptr);
+
+  llvm::StringMap<QualType> Empty;
+  auto *EmptyObj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Empty)).getType());
+  const ObjectLayout *Layout = Context.getObjectLayout(EmptyObj);
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getSize(), 0u);
+  EXPECT_EQ(Layout->getAlignment(), 1u);
+}
+
+namespace {
+
+const EnumLayout *getEnumLayout(TypeContext &Context,
+                                llvm::StringMap<QualType> &&Members) {
+  auto *Enum = static_cast<const EnumType *>(
+      Context.getEnumType(std::move(Members)).getType());
+  return Context.getEnumLayout(Enum);
+}
+
+} // namespace
+
+TEST(EnumLayoutTest, Tag) {
+  TypeContext Context;
+  auto Unit = Context.getUnitType();
+
+  llvm::StringMap<QualType> Members;
+  Members.insert({"red", Unit});
+  Members.insert({"green", Unit});
+  Members.insert({"blue", Unit});
+  const EnumLayout *Layout = getEnumLayout(Context, std::move(Members));
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getKind(), EnumLayout::Kind::Tag);
+  EXPECT_EQ(Layout->getStorage().Size, 1u);
+  EXPECT_FALSE(Layout->getStorage().IsGCPointer);
+
+  // tags follow the order of the names
+  EXPECT_EQ(Layout->getMember("blue")->Tag, 0u);
+  EXPECT_EQ(Layout->getMember("green")->Tag, 1u);
+  EXPECT_EQ(Layout->getMember("red")->Tag, 2u);
+}
+
+TEST(EnumLayoutTest, NullablePointer) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Members;
+  Members.insert({"some", Context.getArrayType(
+                              Context.getBuiltinType(NativeType::i32))});
+  Members.insert({"none", Context.getUnitType()});
+  const EnumLayout *Layout = getEnumLayout(Context, std::move(Members));
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getKind(), EnumLayout::Kind::NullablePointer);
+  EXPECT_EQ(Layout->getStorage().Size, 8u);
+  EXPECT_TRUE(Layout->getStorage().IsGCPointer);
+  EXPECT_TRUE(Layout->getMember("some")->IsGCPointer);
+  EXPECT_FALSE(Layout->getMember("none")->IsGCPointer);
+}
+
+TEST(EnumLayoutTest, Inline) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Members;
+  Members.insert({"real", Context.getBuiltinType(NativeType::f64)});
+  Members.insert({"small", Context.getBuiltinType(NativeType::i8)});
+  Members.insert({"empty", Context.getUnitType()});
+  const EnumLayout *Layout = getEnumLayout(Context, std::move(Members));
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getKind(), EnumLayout::Kind::Inline);
+  EXPECT_EQ(Layout->getPayloadOffset(*Layout->getMember("real")), 0u);
+  EXPECT_EQ(Layout->getTagOffset(), 8u);
+  EXPECT_EQ(Layout->getDataSize(), 16u);
+  EXPECT_EQ(Layout->getStorage().Size, 16u);
+  EXPECT_EQ(Layout->getStorage().Align, 8u);
+  EXPECT_FALSE(Layout->getStorage().IsGCPointer);
+}
+
+TEST(EnumLayoutTest, Boxed) {
+  TypeContext Context;
+
+  llvm::StringMap<QualType> Members;
+  Members.insert({"name", Context.getBuiltinType(NativeType::string)});
+  Members.insert({"items", Context.getArrayType(
+                               Context.getBuiltinType(NativeType::i32))});
+  Members.insert({"code", Context.getBuiltinType(NativeType::i32)});
+  const EnumLayout *Layout = getEnumLayout(Context, std::move(Members));
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getKind(), EnumLayout::Kind::Boxed);
+  EXPECT_TRUE(Layout->getStorage().IsGCPointer);
+
+  // gc pointers share the first slot of the box
+  EXPECT_EQ(Layout->getPayloadOffset(*Layout->getMember("name")), 0u);
+  EXPECT_EQ(Layout->getPayloadOffset(*Layout->getMember("items")), 0u);
+  EXPECT_EQ(Layout->getPayloadOffset(*Layout->getMember("code")), 8u);
+  EXPECT_EQ(Layout->getTagOffset(), 12u);
+  EXPECT_EQ(Layout->getDataSize(), 16u);
+}
+
+TEST(EnumLayoutTest, ObjectField) {
+  TypeContext Context;
+  auto Unit = Context.getUnitType();
+
+  llvm::StringMap<QualType> Members;
+  Members.insert({"on", Unit});
+  Members.insert({"off", Unit});
+  auto Switch = Context.getEnumType(std::move(Members));
+
+  llvm::StringMap<QualType> Fields;
+  Fields.insert({"state", Switch});
+  Fields.insert({"count", Context.getBuiltinType(NativeType::i32)});
+  auto *Obj = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Fields)).getType());
+
+  const ObjectLayout *Layout = Context.getObjectLayout(Obj);
+  ASSERT_NE(Layout, nullptr);
+  EXPECT_EQ(Layout->getField("state")->Offset, 4u);
+  EXPECT_EQ(Layout->getSize(), 8u);
+}
+
+TEST(TypeLayoutTest, ValueTypes) {
+  TypeContext Context;
+  auto F64 = Context.getBuiltinType(NativeType::f64);
+
+  llvm::StringMap<QualType> Vec2;
+  Vec2.insert({"x", F64});
+  Vec2.insert({"y", F64});
+  auto *Small = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Vec2)).getType());
+  EXPECT_TRUE(Context.isValueType(Small));
+
+  llvm::StringMap<QualType> Vec3;
+  Vec3.insert({"x", F64});
+  Vec3.insert({"y", F64});
+  Vec3.insert({"z", F64});
+  auto *Large = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Vec3)).getType());
+  EXPECT_FALSE(Context.isValueType(Large));
+
+  llvm::StringMap<QualType> Named;
+  Named.insert({"name", Context.getBuiltinType(NativeType::string)});
+  auto *Pointers = static_cast<const ObjectType *>(
+      Context.getObjectType(std::move(Named)).getType());
+  EXPECT_FALSE(Context.isValueType(Pointers));
+
+  Context.addMutatedObject(Small);
+  EXPECT_FALSE(Context.isValueType(Small));
+}
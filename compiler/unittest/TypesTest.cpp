@@ -85,6 +85,22 @@ TEST(TypeContextTest, PointerIdentityFunc) {
   EXPECT_EQ(F4, F5);
 }
 
+TEST(TypeContextTest, Signature) {
+  TypeContext Context;
+  auto I32 = Context.getBuiltinType(NativeType::i32);
+  auto F64 = Context.getBuiltinType(NativeType::f64);
+
+  llvm::SmallVector<QualType> Params{I32, F64};
+  llvm::SmallVector<QualType> Qualified{I32.mut(true), F64};
+  llvm::SmallVector<QualType> Swapped{F64, I32};
+
+  // signatures ignore qualifiers and the return type
+  const FuncType *S1 = Context.getSignature(Params);
+  EXPECT_EQ(S1, Context.getSignature(Qualified));
+  EXPECT_NE(S1, Context.getSignature(Swapped));
+  EXPECT_EQ(QualType(S1), Context.getFuncType(Params, Context.getUnitType()));
+}
+
 TEST(TypeContextTest, PointerIdentityObject) {
   TypeContext Context;
   auto T1 = Context.getBuiltinType(NativeType::i32);
@@ -104,6 +120,20 @@ TEST(TypeContextTest, PointerIdentityObject) {
   auto O3 = Context.getObjectType(std::move(Fields3));
 
   EXPECT_NE(O1, O3);
+
+  // equal fields inserted in another order
+  auto T2 = Context.getBuiltinType(NativeType::f64);
+  llvm::StringMap<QualType> Fields4;
+  for (const char *Name : {"a", "b", "c", "d", "e", "f", "g", "h"})
+    Fields4.insert({Name, T1});
+  Fields4.insert({"z", T2});
+  llvm::StringMap<QualType> Fields5;
+  Fields5.insert({"z", T2});
+  for (const char *Name : {"h", "g", "f", "e", "d", "c", "b", "a"})
+    Fields5.insert({Name, T1});
+
+  EXPECT_EQ(Context.getObjectType(std::move(Fields4)),
+            Context.getObjectType(std::move(Fields5)));
 }
 
 TEST(TypeContextTest, PointerIdentityEnum) {
@@ -1,6 +1,11 @@
 ; ModuleID = 'add.ll'
 source_filename = "add.ll"
 
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
 declare void @runtime_gc_poll()
 
 declare ptr addrspace(1) @runtime_allocate(i64)
@@ -0,0 +1,80 @@
+; Inline allocation fast path for the nursery collector.
+;
+; The frontend links this module in and calls @runtime_allocate_inline
+; instead of @runtime_allocate_typed. It is alwaysinline, so once inlined an
+; allocation is a bump of the thread's allocation buffer and two header
+; stores; only when the buffer is exhausted, or for objects too big for any
+; buffer, does it call @runtime_allocate_slow, which may collect. It is
+; linkonce_odr like the barrier in barrier.ll, so no copy is left over
+; once every call is inlined.
+;
+; A collection empties every buffer, so no safepoint may fall between the
+; load of the cursor and the store of the bumped one. The function has no gc
+; strategy and gets no poll of its own; it must be inlined after
+; -place-safepoints, which would otherwise put the entry poll of the caller
+; right before the size check, and before -rewrite-statepoints-for-gc, which
+; turns the slow call into a statepoint of the caller.
+;
+; Allocation buffer ABI (see gc.h): @runtime_tlab_cursor and
+; @runtime_tlab_limit bound the free, zeroed part of the buffer. An object
+; takes an 8 byte header plus its payload size rounded up to 8; the header
+; word is `type << 32 | granules << 16` with the type id from
+; @runtime_register_type and the payload size in 8 byte granules.
+;
+; A task may move to another thread inside any call that does not return
+; right away, not only @runtime_yield and @runtime_join, so the address of
+; the buffer of the current thread is only valid until the next call. The
+; rule is that no call may fall between computing that address and using
+; it, and it is enforced here rather than left to the callers: LLVM treats
+; the address of a thread_local as constant within a function and would
+; reuse it across calls once the fast path is inlined, so the address is
+; computed with inline asm instead. The asm reading the thread pointer has
+; side effects and is never merged with another one or moved across a call,
+; and every inlined fast path reads it again right before the cursor. This
+; ties the module to x86-64 ELF, like the stack map sections of the
+; workloads it is linked with. Allocations made here are not seen by
+; runtime tracing.
+
+declare ptr addrspace(1) @runtime_allocate_slow(i64 %size, i32 %type)
+
+define linkonce_odr ptr addrspace(1) @runtime_allocate_inline(i64 %size, i32 %type) alwaysinline {
+entry:
+    %size.round = add i64 %size, 7
+    %size.aligned = and i64 %size.round, -8
+    %total = add i64 %size.aligned, 8
+
+    ; the offsets are fixed at load time, only the thread pointer changes
+    %tp = call i64 asm sideeffect "movq %fs:0, $0", "=r"() "gc-leaf-function"
+    %cursor.off = call i64 asm "movq runtime_tlab_cursor@GOTTPOFF(%rip), $0", "=r"() "gc-leaf-function"
+    %limit.off = call i64 asm "movq runtime_tlab_limit@GOTTPOFF(%rip), $0", "=r"() "gc-leaf-function"
+    %cursor.addr.int = add i64 %tp, %cursor.off
+    %limit.addr.int = add i64 %tp, %limit.off
+    %cursor.addr = inttoptr i64 %cursor.addr.int to ptr
+    %limit.addr = inttoptr i64 %limit.addr.int to ptr
+
+    %cursor = load ptr, ptr %cursor.addr
+    %limit = load ptr, ptr %limit.addr
+    %cursor.int = ptrtoint ptr %cursor to i64
+    %limit.int = ptrtoint ptr %limit to i64
+    %free = sub i64 %limit.int, %cursor.int
+    %fits = icmp ule i64 %total, %free
+    br i1 %fits, label %fast, label %slow
+
+fast:
+    %next = getelementptr i8, ptr %cursor, i64 %total
+    store ptr %next, ptr %cursor.addr
+
+    %type.64 = zext i32 %type to i64
+    %type.bits = shl i64 %type.64, 32
+    %granule.bits = shl i64 %size.aligned, 13
+    %header = or i64 %type.bits, %granule.bits
+    store i64 %header, ptr %cursor
+
+    %payload = getelementptr i8, ptr %cursor, i64 8
+    %obj = addrspacecast ptr %payload to ptr addrspace(1)
+    ret ptr addrspace(1) %obj
+
+slow:
+    %obj.slow = call ptr addrspace(1) @runtime_allocate_slow(i64 %size, i32 %type)
+    ret ptr addrspace(1) %obj.slow
+}
@@ -0,0 +1,51 @@
+; Generational write barrier for the nursery collector.
+;
+; The frontend links this module in and calls @runtime_write_barrier after
+; storing %val into a field of %obj. It is alwaysinline and a gc leaf, so
+; the fast path is a couple of compares at the store site and only stores
+; creating a mature -> nursery edge reach @runtime_remember_object. It is
+; linkonce_odr since runtime.cpp defines the same barrier out of line for
+; code that does not link this module in, such as the JIT.
+;
+; Object header layout (see object_header.h): the flags byte is the first
+; byte of the header word at payload - 8 and bit 1 marks objects already in
+; the remembered set.
+
+@runtime_nursery_start = external global ptr
+@runtime_nursery_end = external global ptr
+
+declare void @runtime_remember_object(ptr addrspace(1) %obj) "gc-leaf-function"
+
+define linkonce_odr void @runtime_write_barrier(ptr addrspace(1) %obj, ptr addrspace(1) %val) alwaysinline "gc-leaf-function" {
+entry:
+    %start = load ptr, ptr @runtime_nursery_start
+    %end = load ptr, ptr @runtime_nursery_end
+    %start.int = ptrtoint ptr %start to i64
+    %end.int = ptrtoint ptr %end to i64
+    %size = sub i64 %end.int, %start.int
+
+    %val.int = ptrtoint ptr addrspace(1) %val to i64
+    %val.off = sub i64 %val.int, %start.int
+    %val.young = icmp ult i64 %val.off, %size
+    br i1 %val.young, label %check.obj, label %done
+
+check.obj:
+    %obj.int = ptrtoint ptr addrspace(1) %obj to i64
+    %obj.off = sub i64 %obj.int, %start.int
+    %obj.young = icmp ult i64 %obj.off, %size
+    br i1 %obj.young, label %done, label %check.remembered
+
+check.remembered:
+    %flags.ptr = getelementptr i8, ptr addrspace(1) %obj, i64 -8
+    %flags = load i8, ptr addrspace(1) %flags.ptr
+    %remembered = and i8 %flags, 2
+    %is.remembered = icmp ne i8 %remembered, 0
+    br i1 %is.remembered, label %done, label %slow
+
+slow:
+    call void @runtime_remember_object(ptr addrspace(1) %obj)
+    br label %done
+
+done:
+    ret void
+}
@@ -0,0 +1,98 @@
+// Allocation throughput benchmark for the nursery fast path.
+//
+// Builds singly linked lists of %ListNode = { i32, ptr addrspace(1) } as
+// list.ll does, dropping each list after kListLength nodes so most nodes die
+// young, and compares two ways compiled code can allocate:
+//   inline - the bump-and-compare fast path of allocate.ll, written out here
+//            in C++, calling into the runtime only when the buffer runs out
+//   call   - an out of line call per node, as runtime_allocate_typed
+//
+// usage: runtime-alloc-bench [million nodes] [repetitions]
+
+#include "gc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+template <uint32_t N> struct static_heap_map {
+  uint32_t num_offsets = N;
+  uint32_t offsets[N];
+};
+
+constexpr static_heap_map<1> list_node_map{1, {8}};
+
+const heap_map *as_map(const void *map) {
+  return static_cast<const heap_map *>(map);
+}
+
+struct list_node {
+  int32_t value;
+  list_node *next;
+};
+
+constexpr size_t kListLength = 1000;
+
+list_node *head = nullptr;
+uint32_t list_node_type = 0;
+
+// Mirrors @runtime_allocate_inline.
+inline void *allocate_inline(uint64_t size, uint32_t type) {
+  size_t total = sizeof(object_metadata) + gc::align_up(size, 8);
+  char *cursor = runtime_tlab_cursor;
+  if (static_cast<size_t>(runtime_tlab_limit - cursor) < total)
+    return gc::allocate(size, type);
+
+  runtime_tlab_cursor = cursor + total;
+  auto *header = reinterpret_cast<object_metadata *>(cursor);
+  gc::init_header(header, size, type);
+  return gc::payload_of(header);
+}
+
+__attribute__((noinline)) void *allocate_call(uint64_t size, uint32_t type) {
+  return gc::allocate(size, type);
+}
+
+template <class Allocate> double build_lists(size_t nodes, Allocate alloc) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nodes; ++i) {
+    if (i % kListLength == 0)
+      head = nullptr;
+    auto *node = static_cast<list_node *>(
+        alloc(sizeof(list_node), list_node_type));
+    node->value = static_cast<int32_t>(i);
+    node->next = head;
+    head = node;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t millions = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50;
+  int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+  size_t nodes = millions * 1000000;
+
+  gc::init();
+  list_node_type = gc::register_type(as_map(&list_node_map));
+  gc::register_root(reinterpret_cast<void **>(&head));
+
+  std::printf("%-7s %10s %10s %12s %10s\n", "path", "nodes", "ms", "Mnodes/s",
+              "minor gcs");
+  for (int rep = 0; rep < repetitions; ++rep) {
+    for (bool inlined : {true, false}) {
+      size_t minors = gc::minor_collections();
+      double ms = inlined ? build_lists(nodes, allocate_inline)
+                          : build_lists(nodes, allocate_call);
+      std::printf("%-7s %10zu %10.1f %12.1f %10zu\n",
+                  inlined ? "inline" : "call", nodes, ms,
+                  nodes / 1e3 / ms, gc::minor_collections() - minors);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+// Fragmentation benchmark for the mature space.
+//
+// Keeps a table of kSlots long-lived objects and overwrites random slots
+// with new ones, so most objects are promoted before they die. Every phase
+// allocates another size class; the few objects of earlier phases that are
+// still alive keep their pages from being freed unless the collector
+// compacts. Each new object points to the one it replaces a slot of the
+// table with, which keeps references for compaction to update.
+//
+// Prints the resident set size after every phase, run it once with
+// RX_GC_MODE=compact and once without to compare.
+//
+// usage: runtime-fragmentation-bench [phases] [slots in thousands]
+
+#include "gc.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t kPayloadSizes[] = {24, 56, 120, 248, 504, 1016};
+
+struct node {
+  node *next;
+  int64_t value;
+};
+
+constexpr struct {
+  uint32_t num_offsets = 1;
+  uint32_t offsets[1] = {0};
+} node_map;
+
+size_t resident_bytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * 4096;
+}
+
+double mib(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int phases = argc > 1 ? std::max(1, std::atoi(argv[1])) : 24;
+  size_t slots = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64) * 1000;
+
+  gc::init();
+  uint32_t node_type =
+      gc::register_type(reinterpret_cast<const heap_map *>(&node_map));
+
+  std::vector<node *> table(slots, nullptr);
+  for (node *&slot : table)
+    gc::register_root(reinterpret_cast<void **>(&slot));
+
+  const char *mode = std::getenv("RX_GC_MODE");
+  std::printf("mode %s, %zu slots\n", mode ? mode : "mark-sweep", slots);
+  std::printf("%6s %8s %10s %10s %10s %8s\n", "phase", "size", "live MiB",
+              "heap MiB", "rss MiB", "majors");
+
+  std::mt19937_64 rng(42);
+  size_t peak_rss = 0;
+  for (int phase = 0; phase < phases; ++phase) {
+    size_t size = kPayloadSizes[phase % std::size(kPayloadSizes)];
+    for (size_t i = 0; i < 4 * slots; ++i) {
+      node *&slot = table[rng() % slots];
+      auto *obj = static_cast<node *>(gc::allocate(size, node_type));
+      obj->next = slot;
+      obj->value = static_cast<int64_t>(i);
+      // keep the chains short, only the link to the replaced node matters
+      if (slot)
+        slot->next = nullptr;
+      slot = obj;
+    }
+
+    gc::collect_major();
+    size_t rss = resident_bytes();
+    peak_rss = std::max(peak_rss, rss);
+    gc::heap_usage usage = gc::usage();
+    std::printf("%6d %8zu %10.1f %10.1f %10.1f %8zu\n", phase, size,
+                mib(usage.live_bytes), mib(usage.heap_bytes), mib(rss),
+                gc::major_collections());
+  }
+
+  runtime_gc_stats_t stats;
+  gc::collect_stats(stats);
+  const runtime_gc_pause_stats &major = stats.pauses[runtime_gc_phase_major];
+  std::printf("peak rss %.1f MiB, major pause p50 %.2f ms max %.2f ms\n",
+              mib(peak_rss), major.p50 / 1e6, major.max / 1e6);
+  return 0;
+}
@@ -0,0 +1,140 @@
+// Mark throughput benchmark for the parallel marker.
+//
+// Builds large object graphs directly in the mature space and times
+// gc::mark_from_roots for increasing marker thread counts:
+//   list  - singly linked list of %ListNode = { i32, ptr addrspace(1) }
+//   tree  - complete binary tree of { ptr, ptr, i64 } nodes
+//   wide  - arrays of pointers to small leaf objects
+//
+// usage: runtime-mark-bench [heap MiB per graph] [max threads]
+
+#include "gc.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <uint32_t N> struct static_heap_map {
+  uint32_t num_offsets = N;
+  uint32_t offsets[N];
+};
+
+constexpr static_heap_map<1> list_node_map{1, {8}};
+constexpr static_heap_map<2> tree_node_map{2, {0, 8}};
+
+const heap_map *as_map(const void *map) {
+  return static_cast<const heap_map *>(map);
+}
+
+struct list_node {
+  int32_t value;
+  list_node *next;
+};
+
+struct tree_node {
+  tree_node *left;
+  tree_node *right;
+  int64_t value;
+};
+
+struct graph {
+  std::string name;
+  std::vector<void *> roots;
+};
+
+graph build_list(size_t bytes) {
+  uint32_t type = gc::register_type(as_map(&list_node_map));
+  size_t count = bytes / (sizeof(object_metadata) + sizeof(list_node));
+  list_node *head = nullptr;
+  for (size_t i = 0; i < count; ++i) {
+    auto *node = static_cast<list_node *>(
+        gc::allocate_mature(sizeof(list_node), type));
+    node->value = static_cast<int32_t>(i);
+    node->next = head;
+    head = node;
+  }
+  return {"list", {head}};
+}
+
+tree_node *build_tree(unsigned depth, uint32_t type) {
+  auto *node = static_cast<tree_node *>(
+      gc::allocate_mature(sizeof(tree_node), type));
+  if (depth) {
+    node->left = build_tree(depth - 1, type);
+    node->right = build_tree(depth - 1, type);
+  }
+  node->value = depth;
+  return node;
+}
+
+graph build_tree_graph(size_t bytes) {
+  size_t nodes = bytes / (sizeof(object_metadata) + sizeof(tree_node));
+  unsigned depth = 0;
+  while ((size_t(2) << (depth + 1)) - 1 <= nodes)
+    ++depth;
+  uint32_t type = gc::register_type(as_map(&tree_node_map));
+  return {"tree", {build_tree(depth, type)}};
+}
+
+graph build_wide(size_t bytes) {
+  constexpr uint32_t kWidth = 4096;
+  static static_heap_map<kWidth> array_map = [] {
+    static_heap_map<kWidth> map;
+    for (uint32_t i = 0; i < kWidth; ++i)
+      map.offsets[i] = i * sizeof(void *);
+    return map;
+  }();
+  uint32_t type = gc::register_type(as_map(&array_map));
+
+  size_t per_array = sizeof(object_metadata) + kWidth * sizeof(void *) +
+                     kWidth * (sizeof(object_metadata) + 8);
+  graph result{"wide", {}};
+  for (size_t n = 0; n < bytes / per_array; ++n) {
+    auto **array = static_cast<void **>(
+        gc::allocate_mature(kWidth * sizeof(void *), type));
+    for (uint32_t i = 0; i < kWidth; ++i)
+      array[i] = gc::allocate_mature(8, 0);
+    result.roots.push_back(array);
+  }
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t mib = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+  unsigned max_threads = argc > 2
+                             ? std::atoi(argv[2])
+                             : std::max(1u, std::thread::hardware_concurrency());
+
+  gc::init();
+
+  std::vector<graph> graphs;
+  graphs.push_back(build_list(mib << 20));
+  graphs.push_back(build_tree_graph(mib << 20));
+  graphs.push_back(build_wide(mib << 20));
+
+  std::printf("%-6s %8s %12s %10s %10s %12s\n", "graph", "threads", "objects",
+              "MiB", "ms", "MiB/s");
+  for (const graph &g : graphs) {
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+      gc::mature.clear_marks();
+      gc::large.clear_marks();
+      auto start = std::chrono::steady_clock::now();
+      gc::mark_stats stats = gc::mark_from_roots(g.roots, threads);
+      auto end = std::chrono::steady_clock::now();
+
+      double ms = std::chrono::duration<double, std::milli>(end - start).count();
+      double marked_mib = stats.bytes / double(1 << 20);
+      std::printf("%-6s %8u %12zu %10.1f %10.2f %12.1f\n", g.name.c_str(),
+                  threads, stats.objects, marked_mib, ms,
+                  marked_mib / (ms / 1000.0));
+    }
+  }
+  return 0;
+}
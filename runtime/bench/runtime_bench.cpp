@@ -0,0 +1,147 @@
+// Allocation and gc benchmark suite of compiled workloads.
+//
+// The workloads in bench/workloads are LLVM IR as the frontend emits it:
+// allocations through @runtime_allocate_inline and stores of gc pointers
+// followed by @runtime_write_barrier. CMake links them with allocate.ll and
+// barrier.ll, runs the statepoint pipeline of test.sh and links the object
+// with the runtime, whose main runs program_entry below as the root task.
+//
+// Every workload starts after a major collection with the gc statistics and
+// the peak RSS reset, and reports as JSON on stdout:
+//   operations            what the workload returns, see its .ll file
+//   operations_per_second
+//   max_pause_ns          longest minor or major pause
+//   p99_pause_ns          99th percentile of the minor pauses
+//   peak_rss_bytes        VmHWM, reset through /proc/self/clear_refs
+//
+// RX_BENCH selects workloads by a comma separated list of names and
+// RX_BENCH_SCALE multiplies every problem size, e.g.
+//   RX_BENCH=binary_trees,hashmap_churn RX_BENCH_SCALE=0.1 runtime-bench
+
+#include "gc.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+extern "C" {
+int64_t bench_binary_trees(int64_t trees);
+int64_t bench_linked_list(int64_t nodes);
+int64_t bench_string_builder(int64_t bytes);
+int64_t bench_hashmap_churn(int64_t inserts);
+int64_t bench_short_lived(int64_t iterations);
+}
+
+namespace {
+
+struct workload {
+  const char *name;
+  int64_t (*run)(int64_t);
+  int64_t size;
+};
+
+constexpr workload kWorkloads[] = {
+    {"binary_trees", bench_binary_trees, 2000},
+    {"linked_list", bench_linked_list, 50000000},
+    {"string_builder", bench_string_builder, 100000000},
+    {"hashmap_churn", bench_hashmap_churn, 5000000},
+    {"short_lived", bench_short_lived, 50000000},
+};
+
+bool selected(const char *name) {
+  const char *filter = std::getenv("RX_BENCH");
+  if (!filter || !*filter)
+    return true;
+
+  size_t length = std::strlen(name);
+  for (const char *item = filter; item;) {
+    const char *end = std::strchr(item, ',');
+    size_t item_length = end ? end - item : std::strlen(item);
+    if (item_length == length && std::strncmp(item, name, length) == 0)
+      return true;
+    item = end ? end + 1 : nullptr;
+  }
+  return false;
+}
+
+// Starts a new peak of the resident set size, supported since Linux 4.0.
+void reset_peak_rss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+size_t peak_rss() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0)
+      return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+  }
+  return 0;
+}
+
+} // namespace
+
+extern "C" int program_entry() {
+  double scale = 1.0;
+  if (const char *env = std::getenv("RX_BENCH_SCALE"))
+    scale = std::max(0.0, std::atof(env));
+
+  std::printf("{\n  \"scale\": %g,\n  \"workloads\": [", scale);
+  const char *separator = "\n";
+  for (const workload &bench : kWorkloads) {
+    if (!selected(bench.name))
+      continue;
+    auto size = std::max<int64_t>(1, static_cast<int64_t>(bench.size * scale));
+
+    gc::collect_major();
+    size_t minors = gc::minor_collections();
+    size_t majors = gc::major_collections();
+    size_t allocated = gc::usage().allocated_bytes;
+    gc::reset_stats();
+    reset_peak_rss();
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t operations = bench.run(size);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    runtime_gc_stats_t stats;
+    gc::collect_stats(stats);
+    const runtime_gc_pause_stats &minor = stats.pauses[runtime_gc_phase_minor];
+    const runtime_gc_pause_stats &major = stats.pauses[runtime_gc_phase_major];
+
+    std::printf("%s    {\n", separator);
+    std::printf("      \"name\": \"%s\",\n", bench.name);
+    std::printf("      \"size\": %lld,\n", static_cast<long long>(size));
+    std::printf("      \"operations\": %lld,\n",
+                static_cast<long long>(operations));
+    std::printf("      \"seconds\": %.6f,\n", seconds);
+    std::printf("      \"operations_per_second\": %.1f,\n",
+                seconds > 0 ? operations / seconds : 0.0);
+    std::printf("      \"allocated_bytes\": %zu,\n",
+                static_cast<size_t>(stats.allocated_bytes) - allocated);
+    std::printf("      \"minor_collections\": %zu,\n",
+                gc::minor_collections() - minors);
+    std::printf("      \"major_collections\": %zu,\n",
+                gc::major_collections() - majors);
+    std::printf("      \"max_pause_ns\": %llu,\n",
+                static_cast<unsigned long long>(
+                    std::max(minor.max, major.max)));
+    std::printf("      \"p99_pause_ns\": %llu,\n",
+                static_cast<unsigned long long>(minor.p99));
+    std::printf("      \"peak_rss_bytes\": %zu\n", peak_rss());
+    std::printf("    }");
+    std::fflush(stdout);
+    separator = ",\n";
+  }
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,84 @@
+; Binary trees: a long-lived tree of depth 18 stays reachable while %n
+; trees of depth 10 are built bottom up and walked right after. Returns the
+; number of nodes walked, which is every node allocated.
+
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
+declare void @runtime_gc_poll()
+declare i32 @runtime_register_type(ptr) "gc-leaf-function"
+declare ptr addrspace(1) @runtime_allocate_inline(i64, i32)
+declare void @runtime_write_barrier(ptr addrspace(1), ptr addrspace(1))
+
+define private void @gc.safepoint_poll() {
+    call void @runtime_gc_poll()
+    ret void
+}
+
+%Node = type { ptr addrspace(1), ptr addrspace(1) }
+
+@node.map = private constant { i32, [2 x i32] } { i32 2, [2 x i32] [i32 0, i32 8] }
+
+define private ptr addrspace(1) @make_tree(i32 %type, i32 %depth) gc "statepoint-example" {
+entry:
+    %obj = call ptr addrspace(1) @runtime_allocate_inline(i64 16, i32 %type)
+    %is.leaf = icmp eq i32 %depth, 0
+    br i1 %is.leaf, label %leaf, label %inner
+
+leaf:
+    ret ptr addrspace(1) %obj
+
+inner:
+    %child.depth = sub i32 %depth, 1
+    %left = call ptr addrspace(1) @make_tree(i32 %type, i32 %child.depth)
+    %right = call ptr addrspace(1) @make_tree(i32 %type, i32 %child.depth)
+    store ptr addrspace(1) %left, ptr addrspace(1) %obj
+    call void @runtime_write_barrier(ptr addrspace(1) %obj, ptr addrspace(1) %left)
+    %right.ptr = getelementptr %Node, ptr addrspace(1) %obj, i32 0, i32 1
+    store ptr addrspace(1) %right, ptr addrspace(1) %right.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %obj, ptr addrspace(1) %right)
+    ret ptr addrspace(1) %obj
+}
+
+define private i64 @check_tree(ptr addrspace(1) %node) gc "statepoint-example" {
+entry:
+    %left = load ptr addrspace(1), ptr addrspace(1) %node
+    %is.leaf = icmp eq ptr addrspace(1) %left, null
+    br i1 %is.leaf, label %leaf, label %inner
+
+leaf:
+    ret i64 1
+
+inner:
+    %right.ptr = getelementptr %Node, ptr addrspace(1) %node, i32 0, i32 1
+    %right = load ptr addrspace(1), ptr addrspace(1) %right.ptr
+    %left.count = call i64 @check_tree(ptr addrspace(1) %left)
+    %right.count = call i64 @check_tree(ptr addrspace(1) %right)
+    %children = add i64 %left.count, %right.count
+    %count = add i64 %children, 1
+    ret i64 %count
+}
+
+define i64 @bench_binary_trees(i64 %n) gc "statepoint-example" {
+entry:
+    %type = call i32 @runtime_register_type(ptr @node.map)
+    %long.lived = call ptr addrspace(1) @make_tree(i32 %type, i32 18)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %loop ]
+    %tree = call ptr addrspace(1) @make_tree(i32 %type, i32 10)
+    %tree.count = call i64 @check_tree(ptr addrspace(1) %tree)
+    %count.next = add i64 %count, %tree.count
+    %i.next = add i64 %i, 1
+    %done = icmp uge i64 %i.next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    %long.count = call i64 @check_tree(ptr addrspace(1) %long.lived)
+    %total = add i64 %count.next, %long.count
+    ret i64 %total
+}
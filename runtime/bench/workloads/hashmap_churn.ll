@@ -0,0 +1,161 @@
+; Hash map churn: a chained hash map of 4096 buckets, kept in 64 segments
+; of 64 buckets, holds a sliding window of 65536 keys. Every step inserts
+; key %i and removes key %i - 65536, so entries live long enough to be
+; promoted and unlinking them stores young pointers into mature segments
+; and entries. Returns the number of inserts and removals.
+
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
+declare void @runtime_gc_poll()
+declare i32 @runtime_register_type(ptr) "gc-leaf-function"
+declare ptr addrspace(1) @runtime_allocate_inline(i64, i32)
+declare void @runtime_write_barrier(ptr addrspace(1), ptr addrspace(1))
+
+define private void @gc.safepoint_poll() {
+    call void @runtime_gc_poll()
+    ret void
+}
+
+; { key, value, next }
+%Entry = type { i64, i64, ptr addrspace(1) }
+
+; the table and its segments, the top 6 bits of a key's hash pick the
+; segment and the next 6 its bucket
+%Array64 = type [64 x ptr addrspace(1)]
+
+@entry.map = private constant { i32, [1 x i32] } { i32 1, [1 x i32] [i32 16] }
+@array64.map = private constant { i32, [64 x i32] } { i32 64, [64 x i32] [
+    i32 0, i32 8, i32 16, i32 24, i32 32, i32 40, i32 48, i32 56,
+    i32 64, i32 72, i32 80, i32 88, i32 96, i32 104, i32 112, i32 120,
+    i32 128, i32 136, i32 144, i32 152, i32 160, i32 168, i32 176, i32 184,
+    i32 192, i32 200, i32 208, i32 216, i32 224, i32 232, i32 240, i32 248,
+    i32 256, i32 264, i32 272, i32 280, i32 288, i32 296, i32 304, i32 312,
+    i32 320, i32 328, i32 336, i32 344, i32 352, i32 360, i32 368, i32 376,
+    i32 384, i32 392, i32 400, i32 408, i32 416, i32 424, i32 432, i32 440,
+    i32 448, i32 456, i32 464, i32 472, i32 480, i32 488, i32 496, i32 504
+] }
+
+define private ptr addrspace(1) @new_table(i32 %type) gc "statepoint-example" {
+entry:
+    %table = call ptr addrspace(1) @runtime_allocate_inline(i64 512, i32 %type)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+    %segment = call ptr addrspace(1) @runtime_allocate_inline(i64 512, i32 %type)
+    %slot = getelementptr %Array64, ptr addrspace(1) %table, i64 0, i64 %i
+    store ptr addrspace(1) %segment, ptr addrspace(1) %slot
+    call void @runtime_write_barrier(ptr addrspace(1) %table, ptr addrspace(1) %segment)
+    %i.next = add i64 %i, 1
+    %done = icmp eq i64 %i.next, 64
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret ptr addrspace(1) %table
+}
+
+define private void @insert(ptr addrspace(1) %table, i64 %key, i64 %value, i32 %type) gc "statepoint-example" {
+entry:
+    %item = call ptr addrspace(1) @runtime_allocate_inline(i64 24, i32 %type)
+    store i64 %key, ptr addrspace(1) %item
+    %value.ptr = getelementptr %Entry, ptr addrspace(1) %item, i32 0, i32 1
+    store i64 %value, ptr addrspace(1) %value.ptr
+
+    %hash = mul i64 %key, -7046029254386353131
+    %segment.index = lshr i64 %hash, 58
+    %segment.ptr = getelementptr %Array64, ptr addrspace(1) %table, i64 0, i64 %segment.index
+    %segment = load ptr addrspace(1), ptr addrspace(1) %segment.ptr
+    %hash.high = lshr i64 %hash, 52
+    %bucket = and i64 %hash.high, 63
+    %head.ptr = getelementptr %Array64, ptr addrspace(1) %segment, i64 0, i64 %bucket
+    %head = load ptr addrspace(1), ptr addrspace(1) %head.ptr
+    %next.ptr = getelementptr %Entry, ptr addrspace(1) %item, i32 0, i32 2
+    store ptr addrspace(1) %head, ptr addrspace(1) %next.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %item, ptr addrspace(1) %head)
+    store ptr addrspace(1) %item, ptr addrspace(1) %head.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %segment, ptr addrspace(1) %item)
+    ret void
+}
+
+; Returns 1 if %key was found and unlinked.
+define private i64 @remove(ptr addrspace(1) %table, i64 %key) gc "statepoint-example" {
+entry:
+    %hash = mul i64 %key, -7046029254386353131
+    %segment.index = lshr i64 %hash, 58
+    %segment.ptr = getelementptr %Array64, ptr addrspace(1) %table, i64 0, i64 %segment.index
+    %segment = load ptr addrspace(1), ptr addrspace(1) %segment.ptr
+    %hash.high = lshr i64 %hash, 52
+    %bucket = and i64 %hash.high, 63
+    %head.ptr = getelementptr %Array64, ptr addrspace(1) %segment, i64 0, i64 %bucket
+    %head = load ptr addrspace(1), ptr addrspace(1) %head.ptr
+    br label %loop
+
+loop:
+    %prev = phi ptr addrspace(1) [ null, %entry ], [ %current, %advance ]
+    %current = phi ptr addrspace(1) [ %head, %entry ], [ %next, %advance ]
+    %end = icmp eq ptr addrspace(1) %current, null
+    br i1 %end, label %missing, label %compare
+
+compare:
+    %current.key = load i64, ptr addrspace(1) %current
+    %next.ptr = getelementptr %Entry, ptr addrspace(1) %current, i32 0, i32 2
+    %next = load ptr addrspace(1), ptr addrspace(1) %next.ptr
+    %found = icmp eq i64 %current.key, %key
+    br i1 %found, label %unlink, label %advance
+
+advance:
+    br label %loop
+
+unlink:
+    %is.head = icmp eq ptr addrspace(1) %prev, null
+    br i1 %is.head, label %unlink.head, label %unlink.inner
+
+unlink.head:
+    %bucket.ptr = getelementptr %Array64, ptr addrspace(1) %segment, i64 0, i64 %bucket
+    store ptr addrspace(1) %next, ptr addrspace(1) %bucket.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %segment, ptr addrspace(1) %next)
+    ret i64 1
+
+unlink.inner:
+    %prev.next.ptr = getelementptr %Entry, ptr addrspace(1) %prev, i32 0, i32 2
+    store ptr addrspace(1) %next, ptr addrspace(1) %prev.next.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %prev, ptr addrspace(1) %next)
+    ret i64 1
+
+missing:
+    ret i64 0
+}
+
+define i64 @bench_hashmap_churn(i64 %n) gc "statepoint-example" {
+entry:
+    %entry.type = call i32 @runtime_register_type(ptr @entry.map)
+    %array.type = call i32 @runtime_register_type(ptr @array64.map)
+    %table = call ptr addrspace(1) @new_table(i32 %array.type)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %next ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %next ]
+    call void @insert(ptr addrspace(1) %table, i64 %i, i64 %i, i32 %entry.type)
+    %full = icmp uge i64 %i, 65536
+    br i1 %full, label %evict, label %next
+
+evict:
+    %old = sub i64 %i, 65536
+    %removed = call i64 @remove(ptr addrspace(1) %table, i64 %old)
+    %count.evicted = add i64 %count, %removed
+    br label %next
+
+next:
+    %count.removed = phi i64 [ %count, %loop ], [ %count.evicted, %evict ]
+    %count.next = add i64 %count.removed, 1
+    %i.next = add i64 %i, 1
+    %done = icmp uge i64 %i.next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret i64 %count.next
+}
@@ -0,0 +1,79 @@
+; Linked lists of %ListNode as in list.ll: %n nodes are pushed onto a list
+; that is counted and dropped every 1000 nodes, so nearly every node dies
+; in the nursery. Returns the number of nodes counted, which is %n.
+
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
+declare void @runtime_gc_poll()
+declare i32 @runtime_register_type(ptr) "gc-leaf-function"
+declare ptr addrspace(1) @runtime_allocate_inline(i64, i32)
+declare void @runtime_write_barrier(ptr addrspace(1), ptr addrspace(1))
+
+define private void @gc.safepoint_poll() {
+    call void @runtime_gc_poll()
+    ret void
+}
+
+%ListNode = type { i32, ptr addrspace(1) }
+
+@list.node.map = private constant { i32, [1 x i32] } { i32 1, [1 x i32] [i32 8] }
+
+define private i64 @count_list(ptr addrspace(1) %head) gc "statepoint-example" {
+entry:
+    br label %loop
+
+loop:
+    %node = phi ptr addrspace(1) [ %head, %entry ], [ %next, %body ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %body ]
+    %end = icmp eq ptr addrspace(1) %node, null
+    br i1 %end, label %exit, label %body
+
+body:
+    %next.ptr = getelementptr %ListNode, ptr addrspace(1) %node, i32 0, i32 1
+    %next = load ptr addrspace(1), ptr addrspace(1) %next.ptr
+    %count.next = add i64 %count, 1
+    br label %loop
+
+exit:
+    ret i64 %count
+}
+
+define i64 @bench_linked_list(i64 %n) gc "statepoint-example" {
+entry:
+    %type = call i32 @runtime_register_type(ptr @list.node.map)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %next ]
+    %head = phi ptr addrspace(1) [ null, %entry ], [ %head.next, %next ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %next ]
+    %node = call ptr addrspace(1) @runtime_allocate_inline(i64 16, i32 %type)
+    %value = trunc i64 %i to i32
+    store i32 %value, ptr addrspace(1) %node
+    %next.ptr = getelementptr %ListNode, ptr addrspace(1) %node, i32 0, i32 1
+    store ptr addrspace(1) %head, ptr addrspace(1) %next.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %node, ptr addrspace(1) %head)
+    %i.next = add i64 %i, 1
+    %position = urem i64 %i.next, 1000
+    %full = icmp eq i64 %position, 0
+    br i1 %full, label %drop, label %next
+
+drop:
+    %length = call i64 @count_list(ptr addrspace(1) %node)
+    %count.dropped = add i64 %count, %length
+    br label %next
+
+next:
+    %head.next = phi ptr addrspace(1) [ %node, %loop ], [ null, %drop ]
+    %count.next = phi i64 [ %count, %loop ], [ %count.dropped, %drop ]
+    %done = icmp uge i64 %i.next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    %rest = call i64 @count_list(ptr addrspace(1) %head.next)
+    %total = add i64 %count.next, %rest
+    ret i64 %total
+}
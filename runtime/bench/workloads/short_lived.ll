@@ -0,0 +1,53 @@
+; Many short-lived objects: every iteration boxes an integer and puts the
+; box in a pair, and both die right away. Measures the raw allocation rate
+; of the inlined fast path and the cost of nursery collections that find
+; almost nothing alive. Returns the number of objects allocated.
+
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
+declare void @runtime_gc_poll()
+declare i32 @runtime_register_type(ptr) "gc-leaf-function"
+declare ptr addrspace(1) @runtime_allocate_inline(i64, i32)
+declare void @runtime_write_barrier(ptr addrspace(1), ptr addrspace(1))
+
+define private void @gc.safepoint_poll() {
+    call void @runtime_gc_poll()
+    ret void
+}
+
+; { box, value }
+%Pair = type { ptr addrspace(1), i64 }
+
+@pair.map = private constant { i32, [1 x i32] } { i32 1, [1 x i32] [i32 0] }
+
+define i64 @bench_short_lived(i64 %n) gc "statepoint-example" {
+entry:
+    %type = call i32 @runtime_register_type(ptr @pair.map)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %loop ]
+    %box = call ptr addrspace(1) @runtime_allocate_inline(i64 8, i32 0)
+    store i64 %i, ptr addrspace(1) %box
+    %pair = call ptr addrspace(1) @runtime_allocate_inline(i64 16, i32 %type)
+    store ptr addrspace(1) %box, ptr addrspace(1) %pair
+    call void @runtime_write_barrier(ptr addrspace(1) %pair, ptr addrspace(1) %box)
+    %value.ptr = getelementptr %Pair, ptr addrspace(1) %pair, i32 0, i32 1
+    store i64 %i, ptr addrspace(1) %value.ptr
+    %box.loaded = load ptr addrspace(1), ptr addrspace(1) %pair
+    %boxed = load i64, ptr addrspace(1) %box.loaded
+    %value = load i64, ptr addrspace(1) %value.ptr
+    %same = icmp eq i64 %boxed, %value
+    %objects = select i1 %same, i64 2, i64 0
+    %count.next = add i64 %count, %objects
+    %i.next = add i64 %i, 1
+    %done = icmp uge i64 %i.next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    ret i64 %count.next
+}
@@ -0,0 +1,107 @@
+; String builder: %n bytes are appended to builders whose buffer doubles
+; when full, starting at 16 bytes. A builder is dropped once it holds
+; 64 << (k % 12) bytes for the k-th builder, so buffers range from small
+; cells to large objects. Returns the number of bytes appended, read back
+; from the builders.
+
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
+
+declare void @runtime_gc_poll()
+declare i32 @runtime_register_type(ptr) "gc-leaf-function"
+declare ptr addrspace(1) @runtime_allocate_inline(i64, i32)
+declare void @runtime_write_barrier(ptr addrspace(1), ptr addrspace(1))
+declare void @llvm.memcpy.p1.p1.i64(ptr addrspace(1), ptr addrspace(1), i64, i1)
+
+define private void @gc.safepoint_poll() {
+    call void @runtime_gc_poll()
+    ret void
+}
+
+; { length, capacity, bytes }
+%Builder = type { i64, i64, ptr addrspace(1) }
+
+@builder.map = private constant { i32, [1 x i32] } { i32 1, [1 x i32] [i32 16] }
+
+define private ptr addrspace(1) @new_builder(i32 %type) gc "statepoint-example" {
+entry:
+    %data = call ptr addrspace(1) @runtime_allocate_inline(i64 16, i32 0)
+    %builder = call ptr addrspace(1) @runtime_allocate_inline(i64 24, i32 %type)
+    %cap.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 1
+    store i64 16, ptr addrspace(1) %cap.ptr
+    %data.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 2
+    store ptr addrspace(1) %data, ptr addrspace(1) %data.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %builder, ptr addrspace(1) %data)
+    ret ptr addrspace(1) %builder
+}
+
+define private void @append(ptr addrspace(1) %builder, i8 %byte) gc "statepoint-example" {
+entry:
+    %len = load i64, ptr addrspace(1) %builder
+    %cap.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 1
+    %cap = load i64, ptr addrspace(1) %cap.ptr
+    %full = icmp eq i64 %len, %cap
+    br i1 %full, label %grow, label %store
+
+grow:
+    %new.cap = shl i64 %cap, 1
+    %new.data = call ptr addrspace(1) @runtime_allocate_inline(i64 %new.cap, i32 0)
+    %old.data.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 2
+    %old.data = load ptr addrspace(1), ptr addrspace(1) %old.data.ptr
+    call void @llvm.memcpy.p1.p1.i64(ptr addrspace(1) %new.data, ptr addrspace(1) %old.data, i64 %len, i1 false)
+    store ptr addrspace(1) %new.data, ptr addrspace(1) %old.data.ptr
+    call void @runtime_write_barrier(ptr addrspace(1) %builder, ptr addrspace(1) %new.data)
+    %new.cap.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 1
+    store i64 %new.cap, ptr addrspace(1) %new.cap.ptr
+    br label %store
+
+store:
+    %data.ptr = getelementptr %Builder, ptr addrspace(1) %builder, i32 0, i32 2
+    %data = load ptr addrspace(1), ptr addrspace(1) %data.ptr
+    %byte.ptr = getelementptr i8, ptr addrspace(1) %data, i64 %len
+    store i8 %byte, ptr addrspace(1) %byte.ptr
+    %len.next = add i64 %len, 1
+    store i64 %len.next, ptr addrspace(1) %builder
+    ret void
+}
+
+define i64 @bench_string_builder(i64 %n) gc "statepoint-example" {
+entry:
+    %type = call i32 @runtime_register_type(ptr @builder.map)
+    %first = call ptr addrspace(1) @new_builder(i32 %type)
+    br label %loop
+
+loop:
+    %i = phi i64 [ 0, %entry ], [ %i.next, %next ]
+    %k = phi i64 [ 0, %entry ], [ %k.next, %next ]
+    %builder = phi ptr addrspace(1) [ %first, %entry ], [ %builder.next, %next ]
+    %count = phi i64 [ 0, %entry ], [ %count.next, %next ]
+    %byte = trunc i64 %i to i8
+    call void @append(ptr addrspace(1) %builder, i8 %byte)
+    %len = load i64, ptr addrspace(1) %builder
+    %shift = urem i64 %k, 12
+    %limit = shl i64 64, %shift
+    %done.builder = icmp uge i64 %len, %limit
+    br i1 %done.builder, label %drop, label %next
+
+drop:
+    %count.dropped = add i64 %count, %len
+    %k.dropped = add i64 %k, 1
+    %fresh = call ptr addrspace(1) @new_builder(i32 %type)
+    br label %next
+
+next:
+    %builder.next = phi ptr addrspace(1) [ %builder, %loop ], [ %fresh, %drop ]
+    %count.next = phi i64 [ %count, %loop ], [ %count.dropped, %drop ]
+    %k.next = phi i64 [ %k, %loop ], [ %k.dropped, %drop ]
+    %i.next = add i64 %i, 1
+    %done = icmp uge i64 %i.next, %n
+    br i1 %done, label %exit, label %loop
+
+exit:
+    %rest = load i64, ptr addrspace(1) %builder.next
+    %total = add i64 %count.next, %rest
+    ret i64 %total
+}
@@ -0,0 +1,21 @@
+#include "runtime.h"
+#include "stackmap.h"
+
+#include <cstdint>
+
+extern "C" {
+extern int program_entry();
+
+// Every object with statepoints adds the address of its __LLVM_StackMaps
+// section to rx_stackmaps, the linker defines the bounds. They are weak so a
+// program without any statepoints still links.
+extern const uint8_t *const __start_rx_stackmaps[] __attribute__((weak));
+extern const uint8_t *const __stop_rx_stackmaps[] __attribute__((weak));
+}
+
+int main(int argc, char *argv[]) {
+  for (const uint8_t *const *section = __start_rx_stackmaps;
+       section != __stop_rx_stackmaps; ++section)
+    gc::statepoints.add_stackmaps(*section);
+  return runtime_start(program_entry);
+}
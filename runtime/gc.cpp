@@ -0,0 +1,775 @@
+#include "gc.h"
+
+#include "stackmap.h"
+#include "stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <libunwind.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <thread>
+#include <utility>
+
+extern "C" {
+
+char *runtime_nursery_start = nullptr;
+char *runtime_nursery_end = nullptr;
+thread_local constinit char *runtime_tlab_cursor = nullptr;
+thread_local constinit char *runtime_tlab_limit = nullptr;
+}
+
+namespace gc {
+
+nursery young;
+mature_space mature;
+large_object_space large;
+page_table heap_pages;
+std::atomic<bool> safepoint_requested{false};
+const heap_map *type_maps[kMaxTypes] = {};
+
+char *map_aligned(size_t size, size_t align) {
+  size_t reserve = size + align;
+  void *base = mmap(nullptr, reserve, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    trace::log("panic failed to map %zu bytes", size);
+    std::abort();
+  }
+
+  auto begin = reinterpret_cast<uintptr_t>(base);
+  auto aligned = align_up(begin, align);
+  if (aligned != begin)
+    munmap(base, aligned - begin);
+  size_t tail = begin + reserve - (aligned + size);
+  if (tail)
+    munmap(reinterpret_cast<void *>(aligned + size), tail);
+  return reinterpret_cast<char *>(aligned);
+}
+
+void page_table::insert(page_header *page) {
+  std::lock_guard guard(lock);
+  pages.insert(reinterpret_cast<uintptr_t>(page));
+}
+
+void page_table::erase(page_header *page) {
+  std::lock_guard guard(lock);
+  pages.erase(reinterpret_cast<uintptr_t>(page));
+}
+
+namespace {
+
+// objects promoted during the current minor collection that still need
+// their fields scanned
+std::vector<object_metadata *> promoted_worklist;
+
+// mature objects that may point into the nursery
+std::mutex remembered_lock;
+std::vector<object_metadata *> remembered_set;
+
+std::mutex roots_lock;
+std::vector<void **> global_roots;
+
+// Stop-the-world state. running_mutators counts the mutators executing
+// compiled code; the stacks of the others are found through parked_stacks.
+std::mutex world_lock;
+std::condition_variable world_changed;
+size_t running_mutators = 0;
+bool collecting = false;
+std::vector<unw_context_t *> parked_stacks;
+thread_local bool is_mutator = false;
+
+// Allocation buffers of every thread that took one. A minor collection
+// empties them all while the mutators are stopped.
+struct tlab_slot {
+  char **cursor;
+  char **limit;
+};
+
+std::mutex tlabs_lock;
+std::vector<tlab_slot> tlabs;
+
+struct tlab_registration {
+  bool registered = false;
+
+  ~tlab_registration() {
+    if (!registered)
+      return;
+    std::lock_guard guard(tlabs_lock);
+    std::erase_if(tlabs, [](const tlab_slot &slot) {
+      return slot.cursor == &runtime_tlab_cursor;
+    });
+  }
+};
+
+thread_local tlab_registration tlab_owner;
+
+std::vector<void *> scratch_slots;
+
+std::mutex types_lock;
+std::atomic<uint32_t> registered_types{1};
+
+bool tenure_everything = false;
+size_t minor_count = 0;
+size_t major_count = 0;
+
+// Heap accounting, see heap_usage. Only mature_allocated_bytes is written
+// outside of collections.
+size_t retired_eden_bytes = 0;
+std::atomic<size_t> mature_allocated_bytes{0};
+size_t marked_bytes = 0;
+size_t promoted_bytes = 0;
+unsigned marker_threads = 1;
+
+// Major collection policy: collect once the mature bytes allocated or
+// promoted since the last major gc exceed heap_growth times the live bytes
+// it found, or would take the heap past max_heap (0 is unlimited).
+constexpr size_t kMinMajorTrigger = 16 * 1024 * 1024;
+double heap_growth = 1.0;
+size_t max_heap = 0;
+size_t major_trigger = kMinMajorTrigger;
+size_t mature_allocated_at_major = 0;
+
+// RX_GC_MODE=compact: major collections slide the mature objects together
+// rather than sweeping, so fragmentation cannot keep pages alive.
+bool compact_mode = false;
+
+// Only eden and the from-space are evacuated; objects already copied into
+// the to-space are young but must not be copied again.
+bool condemned(const void *ptr) {
+  return young.eden.contains(ptr) || young.from.contains(ptr);
+}
+
+void evacuate(void **slot) {
+  void *obj = *slot;
+  if (!obj || !condemned(obj))
+    return;
+
+  object_metadata *header = header_of(obj);
+  if (is_forwarded(header)) {
+    *slot = forward_of(header);
+    return;
+  }
+
+  size_t total = total_size(header);
+  object_metadata *copy = nullptr;
+  if (!tenure_everything && header->age + 1 < kPromotionAge)
+    copy = young.to.allocate(total);
+  if (!copy) {
+    copy = mature.allocate(total);
+    promoted_worklist.push_back(copy);
+    promoted_bytes += total;
+  }
+
+  std::memcpy(copy, header, total);
+  copy->age = header->age + 1;
+  copy->flags = 0;
+
+  set_forward(header, payload_of(copy));
+  *slot = payload_of(copy);
+}
+
+void scan_object(object_metadata *header, bool is_mature) {
+  const heap_map *map = map_of(header);
+  if (!map)
+    return;
+
+  char *payload = reinterpret_cast<char *>(payload_of(header));
+  bool points_young = false;
+  for (uint32_t i = 0; i < map->num_offsets; ++i) {
+    void **slot = reinterpret_cast<void **>(payload + map->offsets[i]);
+    evacuate(slot);
+    points_young |= *slot && in_nursery(*slot);
+  }
+
+  if (is_mature && points_young && !(header->flags & object_remembered)) {
+    header->flags |= object_remembered;
+    remembered_set.push_back(header);
+  }
+}
+
+// Points `slot` to the new place of a compacted object. Every marked small
+// object was forwarded by mature_space::plan_compaction; large objects and
+// those outside the heap stay where they are.
+void forward(void **slot) {
+  void *obj = *slot;
+  if (!obj)
+    return;
+  page_header *page = heap_pages.page_of(obj);
+  if (!page || page->is_large())
+    return;
+  assert(is_forwarded(header_of(obj)) && "reference to an unmarked object");
+  *slot = forward_of(header_of(obj));
+}
+
+void forward_fields(object_metadata *header, const heap_map *map) {
+  if (!map)
+    return;
+  char *payload = reinterpret_cast<char *>(payload_of(header));
+  for (uint32_t i = 0; i < map->num_offsets; ++i)
+    forward(reinterpret_cast<void **>(payload + map->offsets[i]));
+}
+
+// Relocate the gc pointers spilled in a statepoint frame, moving each base
+// pointer with `move`. The compiler reloads them through gc.relocate after
+// the call returns, so updating the stack slots in place is enough to move
+// the roots. Derived pointers keep their offset from the (possibly moved)
+// base.
+void relocate_frame(const frame_info *frame, char *stack_pointer,
+                    void (*move)(void **)) {
+  auto slot_addr = [&](unsigned idx) {
+    return reinterpret_cast<void **>(stack_pointer +
+                                     frame->slots[idx].offset);
+  };
+
+  scratch_slots.resize(frame->num_slots);
+  for (unsigned slot = 0; slot < frame->num_slots; ++slot)
+    scratch_slots[slot] = *slot_addr(slot);
+
+  for (unsigned slot = 0; slot < frame->num_slots; ++slot) {
+    if (frame->slots[slot].kind < 0)
+      move(slot_addr(slot));
+  }
+
+  for (unsigned slot = 0; slot < frame->num_slots; ++slot) {
+    int32_t base = frame->slots[slot].kind;
+    if (base < 0)
+      continue;
+    char *old_base = static_cast<char *>(scratch_slots[base]);
+    char *new_base = static_cast<char *>(*slot_addr(base));
+    if (old_base == new_base)
+      continue;
+    char *old_derived = static_cast<char *>(scratch_slots[slot]);
+    *slot_addr(slot) = new_base + (old_derived - old_base);
+  }
+}
+
+template <class Fn> void walk_stack(unw_context_t *context, Fn &fn) {
+  unw_cursor_t cursor;
+  unw_init_local(&cursor, context);
+
+  do {
+    unw_word_t pc, sp;
+    unw_get_reg(&cursor, UNW_REG_IP, &pc);
+    unw_get_reg(&cursor, UNW_REG_SP, &sp);
+
+    if (const frame_info *frame = statepoints.lookup(pc))
+      fn(frame, reinterpret_cast<char *>(sp));
+  } while (unw_step(&cursor) > 0);
+}
+
+// Visit the statepoint frames of the collecting thread and of every parked
+// mutator. Only called with the world stopped.
+template <class Fn> void for_each_statepoint_frame(Fn &&fn) {
+  unw_context_t context;
+  unw_getcontext(&context);
+  walk_stack(&context, fn);
+
+  for (unw_context_t *parked : parked_stacks) {
+    // unw_init_local may write to the context, keep the parked copy intact
+    unw_context_t copy = *parked;
+    walk_stack(&copy, fn);
+  }
+}
+
+void relocate_roots(void (*move)(void **)) {
+  for_each_statepoint_frame([move](const frame_info *frame,
+                                   char *stack_pointer) {
+    relocate_frame(frame, stack_pointer, move);
+  });
+  for (void **slot : global_roots)
+    move(slot);
+}
+
+// Derived pointers point into the same object as their base, so only base
+// slots are needed to mark.
+void gather_roots(std::vector<void *> &roots) {
+  for_each_statepoint_frame([&](const frame_info *frame,
+                                char *stack_pointer) {
+    for (unsigned slot = 0; slot < frame->num_slots; ++slot) {
+      if (frame->slots[slot].kind >= 0)
+        continue;
+      roots.push_back(*reinterpret_cast<void **>(
+          stack_pointer + frame->slots[slot].offset));
+    }
+  });
+  for (void **slot : global_roots)
+    roots.push_back(*slot);
+}
+
+// Returns false if another mutator got to collect first, in which case the
+// caller has been parked until that collection finished.
+bool stop_the_world() {
+  std::unique_lock guard(world_lock);
+  if (collecting) {
+    if (!is_mutator) {
+      world_changed.wait(guard, [] { return !collecting; });
+      return false;
+    }
+    guard.unlock();
+    safepoint();
+    return false;
+  }
+
+  collecting = true;
+  safepoint_requested.store(true, std::memory_order_relaxed);
+  size_t self = is_mutator ? 1 : 0;
+  world_changed.wait(guard, [&] { return running_mutators == self; });
+  return true;
+}
+
+void resume_the_world() {
+  {
+    std::lock_guard guard(world_lock);
+    collecting = false;
+    safepoint_requested.store(false, std::memory_order_relaxed);
+  }
+  world_changed.notify_all();
+}
+
+void scan_remembered_set() {
+  std::vector<object_metadata *> previous;
+  previous.swap(remembered_set);
+  for (object_metadata *header : previous) {
+    header->flags &= ~object_remembered;
+    scan_object(header, true);
+  }
+}
+
+// Byte count with an optional K, M or G suffix.
+size_t parse_size(const char *text) {
+  char *suffix;
+  double value = std::strtod(text, &suffix);
+  switch (*suffix) {
+  case 'g':
+  case 'G':
+    value *= 1024;
+    [[fallthrough]];
+  case 'm':
+  case 'M':
+    value *= 1024;
+    [[fallthrough]];
+  case 'k':
+  case 'K':
+    value *= 1024;
+  }
+  return static_cast<size_t>(value);
+}
+
+size_t mature_growth() {
+  return promoted_bytes +
+         mature_allocated_bytes.load(std::memory_order_relaxed) -
+         mature_allocated_at_major;
+}
+
+// Whether `extra` more mature bytes warrant a major collection first.
+bool major_due(size_t extra) {
+  size_t growth = mature_growth() + extra;
+  if (growth >= major_trigger)
+    return true;
+  return max_heap && marked_bytes + growth > max_heap;
+}
+
+// Empty every allocation buffer, returns the bytes left unused in them.
+size_t retire_tlabs() {
+  std::lock_guard guard(tlabs_lock);
+  size_t unused = 0;
+  for (const tlab_slot &slot : tlabs) {
+    unused += *slot.limit - *slot.cursor;
+    *slot.cursor = *slot.limit = nullptr;
+  }
+  return unused;
+}
+
+void minor_collection(bool tenure_all) {
+  RX_TRACE_PHASE_BEGIN(minor);
+  pause_timer timer(runtime_gc_phase_minor);
+  retired_eden_bytes += young.eden.used() - retire_tlabs();
+  tenure_everything = tenure_all;
+  young.to.reset();
+
+  relocate_roots(evacuate);
+  scan_remembered_set();
+
+  char *scan = young.to.start;
+  while (scan < young.to.cursor || !promoted_worklist.empty()) {
+    while (scan < young.to.cursor) {
+      auto *header = reinterpret_cast<object_metadata *>(scan);
+      scan_object(header, false);
+      scan += total_size(header);
+    }
+    while (!promoted_worklist.empty()) {
+      object_metadata *header = promoted_worklist.back();
+      promoted_worklist.pop_back();
+      scan_object(header, true);
+    }
+  }
+
+  young.eden.reset();
+  young.from.reset();
+  std::swap(young.from, young.to);
+
+  tenure_everything = false;
+  ++minor_count;
+  if constexpr (kVerifyHeap)
+    verify_young(remembered_set, global_roots);
+  RX_TRACE_PHASE_END(minor, young.from.cursor - young.from.start);
+}
+
+// Slides the live small objects of the mature space together, see
+// mature_space::plan_compaction, and returns how many were live. Runs after
+// marking and sweeping the large objects, so every object left in the heap
+// is live and the nursery is empty.
+size_t compact_mature() {
+  assert(remembered_set.empty());
+  std::vector<object_metadata> headers;
+  mature.plan_compaction(headers);
+
+  mature.for_each_planned(headers, [](object_metadata *header,
+                                      const object_metadata &saved) {
+    forward_fields(header, type_maps[saved.type]);
+  });
+  large.for_each_object([](page_header *, object_metadata *header) {
+    forward_fields(header, map_of(header));
+  });
+  relocate_roots(forward);
+
+  mature.finish_compaction(headers);
+  return headers.size();
+}
+
+mark_stats major_collection(unsigned threads) {
+  RX_TRACE_PHASE_BEGIN(major);
+  pause_timer timer(runtime_gc_phase_major);
+  minor_collection(true);
+
+  // marking needs every page swept, so the bitmaps are clear and no page
+  // still holds cells freed by the previous cycle
+  RX_TRACE_PHASE_BEGIN(sweep);
+  uint64_t sweep_time = time_nanoseconds([] { mature.finish_sweep(); });
+  RX_TRACE_PHASE_END(sweep, 0);
+
+  RX_TRACE_PHASE_BEGIN(roots);
+  std::vector<void *> roots;
+  uint64_t root_time = time_nanoseconds([&] { gather_roots(roots); });
+  record_pause(runtime_gc_phase_root_scan, root_time);
+  RX_TRACE_PHASE_END(roots, roots.size());
+
+  RX_TRACE_PHASE_BEGIN(mark);
+  mark_stats stats;
+  uint64_t mark_time = time_nanoseconds([&] {
+    stats = mark_from_roots(roots, threads ? threads : marker_threads);
+  });
+  record_pause(runtime_gc_phase_mark, mark_time);
+  RX_TRACE_PHASE_END(mark, stats.objects);
+  if constexpr (kVerifyHeap)
+    verify_mature(roots, true);
+
+  sweep_time += time_nanoseconds([] {
+    large.sweep();
+    if (!compact_mode)
+      mature.begin_sweep();
+  });
+  record_pause(runtime_gc_phase_sweep, sweep_time);
+
+  if (compact_mode) {
+    RX_TRACE_PHASE_BEGIN(compact);
+    size_t compacted = 0;
+    uint64_t compact_time =
+        time_nanoseconds([&] { compacted = compact_mature(); });
+    record_pause(runtime_gc_phase_compact, compact_time);
+    RX_TRACE_PHASE_END(compact, compacted);
+
+    if constexpr (kVerifyHeap) {
+      roots.clear();
+      gather_roots(roots);
+      verify_mature(roots, false);
+    }
+  }
+
+  marked_bytes = stats.bytes;
+  promoted_bytes = 0;
+  mature_allocated_at_major =
+      mature_allocated_bytes.load(std::memory_order_relaxed);
+  major_trigger = std::max(
+      kMinMajorTrigger, static_cast<size_t>(heap_growth * marked_bytes));
+
+  ++major_count;
+  RX_TRACE_PHASE_END(major, stats.bytes);
+  return stats;
+}
+
+// Called after a major gc, when marked_bytes is exact.
+void check_heap_limit(size_t extra) {
+  if (max_heap && marked_bytes + extra > max_heap) {
+    trace::log("panic heap limit of %zu bytes exceeded, %zu bytes live",
+               max_heap, marked_bytes);
+    std::abort();
+  }
+}
+
+// Collect first if `total` more mature bytes are due for a major gc.
+void make_room(size_t total) {
+  if (major_due(total)) {
+    collect_major();
+    check_heap_limit(total);
+  }
+}
+
+// Zeroed nursery memory for `total` bytes, or nullptr if eden is full.
+// Objects that would waste much of a fresh buffer bypass it.
+object_metadata *allocate_young(size_t total) {
+  char *cursor = runtime_tlab_cursor;
+  if (static_cast<size_t>(runtime_tlab_limit - cursor) >= total) {
+    runtime_tlab_cursor = cursor + total;
+    return reinterpret_cast<object_metadata *>(cursor);
+  }
+
+  char *buffer = nullptr;
+  if (total <= kTlabSize / 8)
+    buffer = reinterpret_cast<char *>(young.allocate(kTlabSize));
+  if (!buffer) {
+    object_metadata *header = young.allocate(total);
+    if (header)
+      std::memset(header, 0, total);
+    return header;
+  }
+
+  if (!tlab_owner.registered) {
+    std::lock_guard guard(tlabs_lock);
+    tlabs.push_back({&runtime_tlab_cursor, &runtime_tlab_limit});
+    tlab_owner.registered = true;
+  }
+  std::memset(buffer, 0, kTlabSize);
+  runtime_tlab_cursor = buffer + total;
+  runtime_tlab_limit = buffer + kTlabSize;
+  return reinterpret_cast<object_metadata *>(buffer);
+}
+
+object_metadata *allocate_small_mature(size_t total) {
+  object_metadata *header = mature.allocate(total);
+  mature_allocated_bytes.fetch_add(total, std::memory_order_relaxed);
+  std::memset(header, 0, total);
+  return header;
+}
+
+object_metadata *allocate_large(size_t size) {
+  object_metadata *header = large.allocate(size);
+  mature_allocated_bytes.fetch_add(total_size(header),
+                                   std::memory_order_relaxed);
+  return header;
+}
+
+} // namespace
+
+void nursery::init() {
+  size_t size = kEdenSize + 2 * kSurvivorSize;
+  char *base = map_aligned(size, kMaturePageSize);
+
+  eden.init(base, kEdenSize);
+  from.init(base + kEdenSize, kSurvivorSize);
+  to.init(base + kEdenSize + kSurvivorSize, kSurvivorSize);
+
+  runtime_nursery_start = base;
+  runtime_nursery_end = base + size;
+}
+
+void init() {
+  young.init();
+
+  marker_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (const char *env = std::getenv("RX_GC_THREADS"))
+    marker_threads = std::max(1, std::atoi(env));
+  if (const char *env = std::getenv("RX_GC_HEAP_GROWTH"))
+    heap_growth = std::max(0.0, std::atof(env));
+  if (const char *env = std::getenv("RX_GC_MAX_HEAP"))
+    max_heap = parse_size(env);
+  if (const char *env = std::getenv("RX_GC_MODE"))
+    compact_mode = std::strcmp(env, "compact") == 0;
+
+  const char *background_sweep = std::getenv("RX_GC_BACKGROUND_SWEEP");
+  if (!background_sweep || std::atoi(background_sweep))
+    mature.start_sweeper();
+
+  reset_stats();
+  const char *report = std::getenv("RX_GC_STATS");
+  if (report && std::atoi(report))
+    std::atexit([] { print_stats(stderr); });
+}
+
+uint32_t register_type(const heap_map *map) {
+  if (!map || !map->num_offsets)
+    return 0;
+
+  std::lock_guard guard(types_lock);
+  uint32_t type = registered_types.load(std::memory_order_relaxed);
+  if (type == kMaxTypes) {
+    trace::log("panic more than %zu heap types", kMaxTypes);
+    std::abort();
+  }
+  type_maps[type] = map;
+  registered_types.store(type + 1, std::memory_order_release);
+  return type;
+}
+
+uint32_t type_count() {
+  return registered_types.load(std::memory_order_acquire);
+}
+
+void *allocate(size_t size, uint32_t type) {
+  size_t total = sizeof(object_metadata) + align_up(size, 8);
+  if (total > kMaxSmallSize) {
+    make_room(total);
+    object_metadata *header = allocate_large(size);
+    header->type = type;
+    return payload_of(header);
+  }
+
+  object_metadata *header = allocate_young(total);
+  if (!header) {
+    collect_minor();
+    header = allocate_young(total);
+  }
+  if (!header) {
+    make_room(total);
+    header = allocate_small_mature(total);
+  }
+
+  init_header(header, size, type);
+  return payload_of(header);
+}
+
+void *try_allocate(size_t size, uint32_t type) {
+  size_t total = sizeof(object_metadata) + align_up(size, 8);
+  if (total > kMaxSmallSize)
+    return nullptr;
+  object_metadata *header = allocate_young(total);
+  if (!header)
+    return nullptr;
+  init_header(header, size, type);
+  return payload_of(header);
+}
+
+void *allocate_mature(size_t size, uint32_t type) {
+  size_t total = sizeof(object_metadata) + align_up(size, 8);
+  object_metadata *header;
+  if (total > kMaxSmallSize) {
+    header = allocate_large(size);
+    header->type = type;
+  } else {
+    header = allocate_small_mature(total);
+    init_header(header, size, type);
+  }
+  return payload_of(header);
+}
+
+void collect_minor(bool tenure_all) {
+  if (!stop_the_world())
+    return;
+  minor_collection(tenure_all);
+  if (major_due(0)) {
+    major_collection(0);
+    check_heap_limit(0);
+  }
+  resume_the_world();
+}
+
+mark_stats collect_major(unsigned threads) {
+  if (!stop_the_world())
+    return {};
+  mark_stats stats = major_collection(threads);
+  resume_the_world();
+  return stats;
+}
+
+
+void enter_mutator(unw_context_t *context) {
+  std::unique_lock guard(world_lock);
+  world_changed.wait(guard, [] { return !collecting; });
+  if (context)
+    std::erase(parked_stacks, context);
+  ++running_mutators;
+  is_mutator = true;
+}
+
+void leave_mutator(unw_context_t *context) {
+  {
+    std::lock_guard guard(world_lock);
+    if (context)
+      parked_stacks.push_back(context);
+    --running_mutators;
+    is_mutator = false;
+  }
+  world_changed.notify_all();
+}
+
+void safepoint() {
+  unw_context_t context;
+  unw_getcontext(&context);
+  leave_mutator(&context);
+  enter_mutator(&context);
+}
+
+void register_root(void **slot) {
+  std::lock_guard guard(roots_lock);
+  global_roots.push_back(slot);
+}
+
+void unregister_root(void **slot) {
+  std::lock_guard guard(roots_lock);
+  std::erase(global_roots, slot);
+}
+
+void remember_object(void *obj) {
+  object_metadata *header = header_of(obj);
+  if (in_nursery(obj))
+    return;
+
+  std::lock_guard guard(remembered_lock);
+  if (header->flags & object_remembered)
+    return;
+  header->flags |= object_remembered;
+  remembered_set.push_back(header);
+}
+
+void release(void *obj) {
+  // nursery objects die with the next minor collection
+  if (in_nursery(obj))
+    return;
+
+  object_metadata *header = header_of(obj);
+  {
+    std::lock_guard guard(remembered_lock);
+    if (header->flags & object_remembered)
+      std::erase(remembered_set, header);
+  }
+
+  // only large objects own their page, the rest are reclaimed by sweeping
+  page_header *page;
+  {
+    std::lock_guard guard(heap_pages.lock);
+    page = heap_pages.page_of(obj);
+  }
+  if (page && page->is_large())
+    large.release(page);
+}
+
+heap_usage usage() {
+  heap_usage result;
+  result.allocated_bytes =
+      retired_eden_bytes + young.eden.used() +
+      mature_allocated_bytes.load(std::memory_order_relaxed);
+  result.live_bytes = marked_bytes + promoted_bytes + young.from.used();
+  result.heap_bytes = kEdenSize + 2 * kSurvivorSize + mature.mapped_bytes() +
+                      large.mapped_bytes();
+  return result;
+}
+
+size_t minor_collections() { return minor_count; }
+
+size_t major_collections() { return major_count; }
+
+} // namespace gc
@@ -0,0 +1,533 @@
+#ifndef RX_RUNTIME_GC_H
+#define RX_RUNTIME_GC_H
+
+#include "object_header.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <libunwind.h>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Builds with RX_GC_VERIFY set check every object header and reference
+// after each collection and panic on the first broken invariant. On by
+// default in debug builds, see CMakeLists.txt.
+#ifndef RX_GC_VERIFY
+#define RX_GC_VERIFY 0
+#endif
+
+extern "C" {
+
+// Pointer map of an allocated type. Offsets are relative to the start of the
+// object payload and name every `addrspace(1)` field of the object.
+struct heap_map {
+  uint32_t num_offsets;
+  uint32_t offsets[];
+};
+
+// Bounds of the nursery, read by the inlined write barrier.
+extern char *runtime_nursery_start;
+extern char *runtime_nursery_end;
+
+// Thread-local allocation buffer of the calling thread, carved out of eden.
+// Part of the allocation ABI in allocate.ll: the inlined fast path bumps
+// runtime_tlab_cursor by the header plus the 8 byte aligned payload size and
+// calls runtime_allocate_slow when that would pass runtime_tlab_limit. The
+// buffer is zeroed when it is handed out, so the fast path only stores the
+// header word. Both are null until the first allocation of a thread
+// and again after every minor collection. A task may resume on another
+// thread after any call, so code must not call anything between computing
+// the address of either and using it; allocate.ll computes it anew for
+// every allocation.
+extern thread_local constinit char *runtime_tlab_cursor;
+extern thread_local constinit char *runtime_tlab_limit;
+}
+
+namespace gc {
+
+constexpr size_t kEdenSize = 4 * 1024 * 1024;
+constexpr size_t kSurvivorSize = 512 * 1024;
+constexpr size_t kMaturePageSize = 256 * 1024;
+constexpr uint8_t kPromotionAge = 2;
+
+// one mark bit per 8 byte granule of a page
+constexpr size_t kGranuleSize = 8;
+constexpr size_t kMarkWords = kMaturePageSize / kGranuleSize / 64;
+
+// Cell sizes of the mature size classes, header included. Larger objects
+// skip the nursery and go to the large object space.
+constexpr std::array<uint32_t, 40> kSizeClasses = {
+    16,    32,    48,    64,    80,    96,    112,   128,   160,   192,
+    224,   256,   320,   384,   448,   512,   640,   768,   896,   1024,
+    1280,  1536,  1792,  2048,  2560,  3072,  3584,  4096,  5120,  6144,
+    7168,  8192,  10240, 12288, 14336, 16384, 20480, 24576, 28672, 32768};
+constexpr size_t kMaxSmallSize = kSizeClasses.back();
+
+// Size of an allocation buffer. Large objects can never fit one, so the
+// inlined fast path needs no size check of its own.
+constexpr size_t kTlabSize = 32 * 1024;
+static_assert(kTlabSize <= kMaxSmallSize);
+
+// granules of large objects, whose 64 bit size is kept in their page
+constexpr uint16_t kSizeInPage = UINT16_MAX;
+static_assert(kMaxSmallSize / 8 < kSizeInPage);
+
+inline object_metadata *header_of(void *obj) {
+  return reinterpret_cast<object_metadata *>(obj) - 1;
+}
+
+inline void *payload_of(object_metadata *header) { return header + 1; }
+
+inline bool is_forwarded(const object_metadata *header) {
+  return header->flags & object_forwarded;
+}
+
+inline void *forward_of(const object_metadata *header) {
+  uintptr_t word;
+  std::memcpy(&word, header, sizeof(word));
+  return reinterpret_cast<void *>(word & ~uintptr_t(object_forwarded));
+}
+
+inline void set_forward(object_metadata *header, void *obj) {
+  uintptr_t word = reinterpret_cast<uintptr_t>(obj) | object_forwarded;
+  std::memcpy(header, &word, sizeof(word));
+}
+
+// Header of a new small object of `type` with `size` payload bytes.
+inline void init_header(object_metadata *header, size_t size, uint32_t type) {
+  header->granules = static_cast<uint16_t>((size + 7) / 8);
+  header->type = type;
+}
+
+constexpr size_t align_up(size_t size, size_t align) {
+  return (size + align - 1) & ~(align - 1);
+}
+
+inline bool in_nursery(const void *ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) -
+             reinterpret_cast<uintptr_t>(runtime_nursery_start) <
+         static_cast<uintptr_t>(runtime_nursery_end - runtime_nursery_start);
+}
+
+class bump_space {
+public:
+  void init(char *base, size_t size) {
+    start = cursor = base;
+    end = base + size;
+  }
+
+  object_metadata *allocate(size_t total) {
+    if (static_cast<size_t>(end - cursor) < total)
+      return nullptr;
+    auto *header = reinterpret_cast<object_metadata *>(cursor);
+    cursor += total;
+    return header;
+  }
+
+  // allocate() for spaces shared by several mutator threads
+  object_metadata *allocate_atomic(size_t total) {
+    std::atomic_ref<char *> shared(cursor);
+    char *old = shared.load(std::memory_order_relaxed);
+    do {
+      if (static_cast<size_t>(end - old) < total)
+        return nullptr;
+    } while (!shared.compare_exchange_weak(old, old + total,
+                                           std::memory_order_relaxed));
+    return reinterpret_cast<object_metadata *>(old);
+  }
+
+  bool contains(const void *ptr) const {
+    return ptr >= start && ptr < end;
+  }
+
+  // may race with allocate_atomic
+  size_t used() {
+    return std::atomic_ref<char *>(cursor).load(std::memory_order_relaxed) -
+           start;
+  }
+
+  void reset() { cursor = start; }
+
+public:
+  char *start = nullptr;
+  char *cursor = nullptr;
+  char *end = nullptr;
+};
+
+// Eden plus two survivor semispaces carved out of a single mapping, so a
+// single range check answers "is this object young".
+class nursery {
+public:
+  void init();
+  object_metadata *allocate(size_t total) {
+    return eden.allocate_atomic(total);
+  }
+
+public:
+  bump_space eden;
+  bump_space from;
+  bump_space to;
+};
+
+char *map_aligned(size_t size, size_t align);
+
+enum class sweep_state : uint8_t { swept, unswept, sweeping };
+
+// Free cells of a mature page link through their first payload word.
+inline object_metadata *&next_free(object_metadata *cell) {
+  return *reinterpret_cast<object_metadata **>(payload_of(cell));
+}
+
+// Every mature page starts with this header. Small pages hold cells of a
+// single size class; large objects get a mapping of their own with the same
+// header, so the page of any mature object is found by masking its address.
+struct page_header {
+  size_t mapping_size;
+  object_metadata *free_list;
+  char *bump;  // cells at or past bump were never handed out
+  char *limit; // end of the last whole cell
+  size_t large_size; // payload size of the object of a large page
+  uint32_t cell_size; // 0 for large pages
+  uint32_t live_cells;
+  uint8_t size_class;
+  std::atomic<sweep_state> state;
+  std::atomic<uint64_t> mark_bits[kMarkWords];
+
+  char *begin();
+  bool is_large() const { return cell_size == 0; }
+
+  object_metadata *take_cell() {
+    if (object_metadata *cell = free_list) {
+      free_list = next_free(cell);
+      return cell;
+    }
+    if (bump + cell_size > limit)
+      return nullptr;
+    auto *cell = reinterpret_cast<object_metadata *>(bump);
+    bump += cell_size;
+    return cell;
+  }
+};
+
+constexpr size_t kPagePayloadOffset = align_up(sizeof(page_header), 16);
+
+inline char *page_header::begin() {
+  return reinterpret_cast<char *>(this) + kPagePayloadOffset;
+}
+
+inline size_t total_size(const object_metadata *header) {
+  if (header->granules == kSizeInPage) {
+    auto page = reinterpret_cast<uintptr_t>(header) & ~(kMaturePageSize - 1);
+    size_t size = reinterpret_cast<const page_header *>(page)->large_size;
+    return sizeof(object_metadata) + align_up(size, 8);
+  }
+  return sizeof(object_metadata) + header->granules * size_t(8);
+}
+
+// Start addresses of every mature and large page. Written under `lock`;
+// collections read it without while the mutators are stopped.
+class page_table {
+public:
+  void insert(page_header *page);
+  void erase(page_header *page);
+
+  // Page owning `ptr`, or nullptr if it does not point into the mature heap.
+  page_header *page_of(const void *ptr) const {
+    auto page = reinterpret_cast<uintptr_t>(ptr) & ~(kMaturePageSize - 1);
+    if (!pages.contains(page))
+      return nullptr;
+    return reinterpret_cast<page_header *>(page);
+  }
+
+public:
+  std::mutex lock;
+
+private:
+  std::unordered_set<uintptr_t> pages;
+};
+
+extern page_table heap_pages;
+
+// Mature objects live in size-segregated pages. After a major mark every
+// page is queued for sweeping; pages are swept lazily by the allocator when
+// it needs a cell of that size class, or by the background sweeper thread,
+// so the pause does not grow with the heap size.
+class mature_space {
+public:
+  ~mature_space();
+
+  // `total` must not exceed kMaxSmallSize
+  object_metadata *allocate(size_t total);
+
+  // Atomically set the mark bit of `header`, returns false if it was
+  // already marked.
+  static bool try_mark(page_header *page, object_metadata *header) {
+    size_t granule = (reinterpret_cast<char *>(header) -
+                      reinterpret_cast<char *>(page)) /
+                     kGranuleSize;
+    uint64_t bit = uint64_t(1) << (granule % 64);
+    uint64_t prev = page->mark_bits[granule / 64].fetch_or(
+        bit, std::memory_order_relaxed);
+    return !(prev & bit);
+  }
+
+  static bool is_marked(page_header *page, object_metadata *header) {
+    size_t granule = (reinterpret_cast<char *>(header) -
+                      reinterpret_cast<char *>(page)) /
+                     kGranuleSize;
+    uint64_t bit = uint64_t(1) << (granule % 64);
+    return page->mark_bits[granule / 64].load(std::memory_order_relaxed) &
+           bit;
+  }
+
+  void clear_marks();
+
+  // Called after marking: queues every page for sweeping.
+  void begin_sweep();
+
+  // Sweep whatever is still queued and wait for the background sweeper.
+  void finish_sweep();
+
+  void start_sweeper();
+  void stop_sweeper();
+
+  size_t page_count();
+
+  // bytes mapped for pages that hold objects, empty pages excluded
+  size_t mapped_bytes();
+
+  // Calls fn(page, header) for every allocated cell. Only while no sweep
+  // runs, i.e. between finish_sweep and begin_sweep.
+  template <class Fn> void for_each_object(Fn &&fn) {
+    std::lock_guard guard(pages_lock);
+    for (page_header *page : pages) {
+      for (char *cell = page->begin(); cell < page->bump;
+           cell += page->cell_size) {
+        auto *header = reinterpret_cast<object_metadata *>(cell);
+        if (!(header->flags & object_free))
+          fn(page, header);
+      }
+    }
+  }
+
+  // Mark-compact mode, run after marking instead of begin_sweep. Slides the
+  // marked cells of each size class into the first of its pages, in the
+  // three passes of Lisp-2 compaction: plan_compaction forwards every marked
+  // cell to its new place and saves its header in `headers`, the caller
+  // updates every reference with for_each_planned, and finish_compaction
+  // moves the objects and returns the emptied pages.
+  void plan_compaction(std::vector<object_metadata> &headers);
+
+  // Calls fn(header, saved) for every planned object, with `header` still
+  // at its old place and forwarded and `saved` its original header.
+  template <class Fn>
+  void for_each_planned(const std::vector<object_metadata> &headers, Fn &&fn) {
+    size_t index = 0;
+    for_each_marked([&](object_metadata *header) {
+      fn(header, headers[index++]);
+    });
+  }
+
+  void finish_compaction(const std::vector<object_metadata> &headers);
+
+private:
+  struct size_class_pages {
+    std::mutex lock;
+    page_header *current = nullptr;
+    std::vector<page_header *> available; // swept, with free cells
+    std::vector<page_header *> unswept;
+  };
+
+  page_header *map_page(size_t size);
+  page_header *fresh_page(uint8_t size_class);
+
+  void sweep_page(page_header *page);
+  bool sweep_one(size_class_pages &pages);
+  void sweeper_loop();
+
+  // Marked cells of the pages being compacted, in the order they slide.
+  template <class Fn> void for_each_marked(Fn &&fn) {
+    for (page_header *page : compaction_order) {
+      for (char *cell = page->begin(); cell < page->bump;
+           cell += page->cell_size) {
+        auto *header = reinterpret_cast<object_metadata *>(cell);
+        if (is_marked(page, header))
+          fn(header);
+      }
+    }
+  }
+
+private:
+  std::array<size_class_pages, kSizeClasses.size()> classes;
+
+  // guards the page lists below
+  std::mutex pages_lock;
+  std::vector<page_header *> pages;
+  std::vector<page_header *> empty_pages;
+
+  // between plan_compaction and finish_compaction: the small pages ordered
+  // by size class, and where their bump will be once compacted
+  std::vector<page_header *> compaction_order;
+  std::vector<char *> compacted_bumps;
+
+  std::thread sweeper;
+  std::mutex sweeper_lock;
+  std::condition_variable sweeper_wake;
+  std::condition_variable sweep_done;
+  size_t pending_pages = 0;
+  bool sweeper_exit = false;
+};
+
+// Objects too big for a size class. Each gets a mapping of its own, starting
+// with a page_header so it is marked like any mature object. Large objects
+// are never copied; dead ones are unmapped right after marking, and
+// release() unmaps one immediately.
+class large_object_space {
+public:
+  // Header of a new object with `size` payload bytes. The mapping is fresh,
+  // so the object is already zeroed.
+  object_metadata *allocate(size_t size);
+  void release(page_header *page);
+
+  void clear_marks();
+  void sweep();
+
+  size_t mapped_bytes();
+
+  template <class Fn> void for_each_object(Fn &&fn) {
+    std::lock_guard guard(lock);
+    for (page_header *page : pages)
+      fn(page, reinterpret_cast<object_metadata *>(page->begin()));
+  }
+
+private:
+  void unmap(page_header *page);
+
+private:
+  std::mutex lock;
+  std::vector<page_header *> pages;
+};
+
+extern nursery young;
+extern mature_space mature;
+extern large_object_space large;
+
+struct mark_stats {
+  size_t objects = 0;
+  size_t bytes = 0;
+};
+
+constexpr size_t kMaxTypes = 1 << 16;
+
+// Heap maps indexed by the type id in object headers. Type 0 has no gc
+// pointers; unregistered ids read as nullptr as well.
+extern const heap_map *type_maps[kMaxTypes];
+
+// Register the pointer map of a heap type, returning the id to allocate it
+// with. Not to be called while the calling thread could be collecting.
+uint32_t register_type(const heap_map *map);
+
+// Number of ids handed out so far, type 0 included.
+uint32_t type_count();
+
+inline const heap_map *map_of(const object_metadata *header) {
+  return type_maps[header->type];
+}
+
+void init();
+
+// Allocate a zeroed object of `type` with `size` payload bytes from the
+// thread's allocation buffer, collecting the nursery if it is exhausted.
+void *allocate(size_t size, uint32_t type);
+
+// allocate() without collecting: nullptr where allocate would have to
+// collect first. Callers holding unrooted pointers try this before rooting
+// them and falling back to allocate.
+void *try_allocate(size_t size, uint32_t type);
+
+// Allocate a zeroed object directly in the mature or large object space.
+// Unlike allocate it never collects, so callers may hold unrooted pointers.
+void *allocate_mature(size_t size, uint32_t type);
+
+// Evacuate live nursery objects, promoting those that survived
+// kPromotionAge collections. With `tenure_all` every survivor is promoted,
+// leaving the nursery empty. Runs a major collection as well once the mature
+// heap has grown by RX_GC_HEAP_GROWTH (default 1.0) times the live bytes of
+// the last one, or would exceed RX_GC_MAX_HEAP.
+void collect_minor(bool tenure_all = false);
+
+// Tenure the nursery, then mark the mature heap from the stack and
+// registered roots using `threads` markers (0 uses the configured count).
+mark_stats collect_major(unsigned threads = 0);
+
+// Stop-the-world protocol. A mutator runs compiled code between
+// enter_mutator and leave_mutator. While left, its stack is described by
+// `context` (nullptr when it has no frames to scan, e.g. a finished task) and
+// the collector scans it in place; enter_mutator blocks while a collection is
+// in progress. Threads that never enter, such as the benchmarks' main thread,
+// may collect on their own.
+void enter_mutator(unw_context_t *context);
+void leave_mutator(unw_context_t *context);
+
+// Set while a collection waits for the running mutators to stop.
+extern std::atomic<bool> safepoint_requested;
+
+// Park the calling mutator until the pending collection has finished.
+void safepoint();
+
+// Run `fn`, which may suspend the calling mutator (e.g. switch fibers), with
+// the mutator parked. The context must be taken in this frame so it stays
+// valid until `fn` returns.
+template <class Fn> void blocking_call(Fn &&fn) {
+  unw_context_t context;
+  unw_getcontext(&context);
+  leave_mutator(&context);
+  fn();
+  enter_mutator(&context);
+}
+
+// Parallel mark of the mature heap from `roots`. Marks accumulate in the page
+// bitmaps until cleared with mature_space::clear_marks.
+mark_stats mark_from_roots(const std::vector<void *> &roots, unsigned threads);
+
+constexpr bool kVerifyHeap = RX_GC_VERIFY;
+
+// Heap verifier of RX_GC_VERIFY builds, run with the world stopped. After a
+// minor collection it checks the survivors, the remembered set and the
+// global roots; after the mark of a major one every mature object, with
+// marked objects only pointing to marked ones, and after a compaction every
+// mature object, as all of them are live.
+void verify_young(const std::vector<object_metadata *> &remembered,
+                  const std::vector<void **> &roots);
+void verify_mature(const std::vector<void *> &roots, bool marked);
+
+struct heap_usage {
+  // since startup, the current allocation buffers count as allocated
+  size_t allocated_bytes = 0;
+  // marked by the last major gc plus what was promoted or survived since
+  size_t live_bytes = 0;
+  size_t heap_bytes = 0; // nursery plus mapped mature pages
+};
+
+heap_usage usage();
+
+// Slots outside the stack, such as runtime globals, that hold gc pointers.
+void register_root(void **slot);
+void unregister_root(void **slot);
+
+void remember_object(void *obj);
+
+void release(void *obj);
+
+size_t minor_collections();
+size_t major_collections();
+
+} // namespace gc
+
+#endif
@@ -0,0 +1,75 @@
+#include "gc.h"
+
+#include <new>
+#include <sys/mman.h>
+
+namespace gc {
+
+namespace {
+
+// the object of a large page starts at its payload offset
+constexpr size_t kMarkWord = kPagePayloadOffset / kGranuleSize / 64;
+
+} // namespace
+
+object_metadata *large_object_space::allocate(size_t size) {
+  size_t total = sizeof(object_metadata) + align_up(size, 8);
+  size_t mapping_size = align_up(kPagePayloadOffset + total, 4096);
+
+  auto *page = new (map_aligned(mapping_size, kMaturePageSize)) page_header{};
+  page->mapping_size = mapping_size;
+  page->large_size = size;
+  heap_pages.insert(page);
+  {
+    std::lock_guard guard(lock);
+    pages.push_back(page);
+  }
+
+  auto *header = reinterpret_cast<object_metadata *>(page->begin());
+  header->granules = kSizeInPage;
+  return header;
+}
+
+void large_object_space::unmap(page_header *page) {
+  heap_pages.erase(page);
+  munmap(page, page->mapping_size);
+}
+
+void large_object_space::release(page_header *page) {
+  {
+    std::lock_guard guard(lock);
+    std::erase(pages, page);
+  }
+  unmap(page);
+}
+
+void large_object_space::clear_marks() {
+  std::lock_guard guard(lock);
+  for (page_header *page : pages)
+    page->mark_bits[kMarkWord].store(0, std::memory_order_relaxed);
+}
+
+// Large objects are few and unmapping is cheap, so they are swept right
+// after marking rather than by the sweeper.
+void large_object_space::sweep() {
+  std::lock_guard guard(lock);
+  std::erase_if(pages, [&](page_header *page) {
+    auto *header = reinterpret_cast<object_metadata *>(page->begin());
+    if (mature_space::is_marked(page, header)) {
+      page->mark_bits[kMarkWord].store(0, std::memory_order_relaxed);
+      return false;
+    }
+    unmap(page);
+    return true;
+  });
+}
+
+size_t large_object_space::mapped_bytes() {
+  std::lock_guard guard(lock);
+  size_t bytes = 0;
+  for (page_header *page : pages)
+    bytes += page->mapping_size;
+  return bytes;
+}
+
+} // namespace gc
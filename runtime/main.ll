@@ -1,5 +1,8 @@
 
-module asm ".globl __LLVM_StackMaps"
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
 
 declare void @runtime_gc_poll()
 declare i8 addrspace(1)* @runtime_allocate(i64 %size)
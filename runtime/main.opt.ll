@@ -1,7 +1,10 @@
 ; ModuleID = 'main.ll'
 source_filename = "main.ll"
 
-module asm ".globl __LLVM_StackMaps"
+module asm ".pushsection rx_stackmaps,\22aw\22,@progbits"
+module asm ".p2align 3"
+module asm ".quad __LLVM_StackMaps"
+module asm ".popsection"
 
 declare void @runtime_gc_poll()
 
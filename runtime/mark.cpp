@@ -0,0 +1,146 @@
+#include "gc.h"
+#include "work_stealing_deque.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace gc {
+
+namespace {
+
+using gray_queue = work_stealing_deque<void *>;
+
+struct alignas(64) marker_state {
+  gray_queue queue;
+  mark_stats stats;
+  uint64_t rng;
+};
+
+// Each marker drains its own deque and steals from the others once it runs
+// dry. A marker that finds no work anywhere parks in `idle`; marking is done
+// when every marker is idle, as only active markers push.
+class parallel_marker {
+public:
+  explicit parallel_marker(unsigned threads) {
+    for (unsigned i = 0; i < threads; ++i) {
+      markers.push_back(std::make_unique<marker_state>());
+      markers.back()->rng = 0x9e3779b97f4a7c15ull * (i + 1);
+    }
+  }
+
+  mark_stats run(const std::vector<void *> &roots) {
+    for (size_t i = 0; i < roots.size(); ++i) {
+      marker_state &owner = *markers[i % markers.size()];
+      if (mark(roots[i], owner.stats))
+        owner.queue.push(roots[i]);
+    }
+
+    std::vector<std::thread> helpers;
+    for (unsigned id = 1; id < markers.size(); ++id)
+      helpers.emplace_back([this, id] { work(id); });
+    work(0);
+    for (auto &helper : helpers)
+      helper.join();
+
+    mark_stats total;
+    for (auto &state : markers) {
+      total.objects += state->stats.objects;
+      total.bytes += state->stats.bytes;
+    }
+    return total;
+  }
+
+private:
+  static bool mark(void *obj, mark_stats &stats) {
+    if (!obj)
+      return false;
+    page_header *page = heap_pages.page_of(obj);
+    if (!page)
+      return false;
+    object_metadata *header = header_of(obj);
+    if (!mature_space::try_mark(page, header))
+      return false;
+    ++stats.objects;
+    stats.bytes += total_size(header);
+    return true;
+  }
+
+  static void scan(void *obj, marker_state &self) {
+    const heap_map *map = map_of(header_of(obj));
+    if (!map)
+      return;
+
+    char *payload = static_cast<char *>(obj);
+    for (uint32_t i = 0; i < map->num_offsets; ++i) {
+      void *child = *reinterpret_cast<void **>(payload + map->offsets[i]);
+      if (mark(child, self.stats))
+        self.queue.push(child);
+    }
+  }
+
+  bool steal(unsigned id, void *&out) {
+    marker_state &self = *markers[id];
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+
+    size_t count = markers.size();
+    size_t start = self.rng % count;
+    for (size_t i = 0; i < count; ++i) {
+      size_t victim = (start + i) % count;
+      if (victim != id && markers[victim]->queue.steal(out))
+        return true;
+    }
+    return false;
+  }
+
+  bool any_work() const {
+    for (auto &state : markers) {
+      if (!state->queue.empty())
+        return true;
+    }
+    return false;
+  }
+
+  void work(unsigned id) {
+    marker_state &self = *markers[id];
+    void *obj;
+
+    for (;;) {
+      while (self.queue.pop(obj))
+        scan(obj, self);
+
+      if (steal(id, obj)) {
+        scan(obj, self);
+        continue;
+      }
+
+      idle.fetch_add(1, std::memory_order_acq_rel);
+      for (;;) {
+        if (any_work()) {
+          idle.fetch_sub(1, std::memory_order_acq_rel);
+          break;
+        }
+        if (idle.load(std::memory_order_acquire) == markers.size())
+          return;
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  std::vector<std::unique_ptr<marker_state>> markers;
+  std::atomic<size_t> idle{0};
+};
+
+} // namespace
+
+mark_stats mark_from_roots(const std::vector<void *> &roots,
+                           unsigned threads) {
+  parallel_marker marker(std::max(1u, threads));
+  return marker.run(roots);
+}
+
+} // namespace gc
@@ -0,0 +1,347 @@
+#include "gc.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+namespace gc {
+
+namespace {
+
+constexpr uint8_t kNoSizeClass = 0xff;
+
+uint8_t size_class_of(size_t total) {
+  auto it = std::lower_bound(kSizeClasses.begin(), kSizeClasses.end(), total);
+  return static_cast<uint8_t>(it - kSizeClasses.begin());
+}
+
+void clear_mark_bits(page_header *page, size_t words) {
+  for (size_t word = 0; word < std::min(words, kMarkWords); ++word)
+    page->mark_bits[word].store(0, std::memory_order_relaxed);
+}
+
+// Hand the cells of a page from `from` on back to the OS, they read as zero
+// when reused. The header stays resident.
+void release_cells(page_header *page, char *from) {
+  auto begin = align_up(reinterpret_cast<uintptr_t>(from), 4096);
+  auto end = reinterpret_cast<uintptr_t>(page) + kMaturePageSize;
+  if (begin < end)
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+}
+
+} // namespace
+
+mature_space::~mature_space() { stop_sweeper(); }
+
+// callers hold pages_lock
+page_header *mature_space::map_page(size_t size) {
+  auto *page = new (map_aligned(size, kMaturePageSize)) page_header{};
+  page->mapping_size = size;
+  page->size_class = kNoSizeClass;
+  heap_pages.insert(page);
+  return page;
+}
+
+page_header *mature_space::fresh_page(uint8_t size_class) {
+  page_header *page;
+  {
+    std::lock_guard guard(pages_lock);
+    if (!empty_pages.empty()) {
+      page = empty_pages.back();
+      empty_pages.pop_back();
+    } else {
+      page = map_page(kMaturePageSize);
+      pages.push_back(page);
+    }
+  }
+
+  uint32_t cell_size = kSizeClasses[size_class];
+  char *end = reinterpret_cast<char *>(page) + kMaturePageSize;
+  page->cell_size = cell_size;
+  page->size_class = size_class;
+  page->free_list = nullptr;
+  page->bump = page->begin();
+  page->limit = page->begin() + (end - page->begin()) / cell_size * cell_size;
+  page->live_cells = 0;
+  page->state.store(sweep_state::swept, std::memory_order_release);
+  return page;
+}
+
+object_metadata *mature_space::allocate(size_t total) {
+  assert(total <= kMaxSmallSize && "large objects have their own space");
+
+  uint8_t size_class = size_class_of(total);
+  size_class_pages &pages = classes[size_class];
+  std::unique_lock guard(pages.lock);
+
+  for (;;) {
+    if (pages.current) {
+      if (object_metadata *cell = pages.current->take_cell())
+        return cell;
+    }
+
+    if (!pages.available.empty()) {
+      pages.current = pages.available.back();
+      pages.available.pop_back();
+      continue;
+    }
+
+    // sweep on demand rather than waiting for the background sweeper
+    if (!pages.unswept.empty()) {
+      page_header *page = pages.unswept.back();
+      pages.unswept.pop_back();
+      page->state.store(sweep_state::sweeping, std::memory_order_relaxed);
+
+      guard.unlock();
+      sweep_page(page);
+      guard.lock();
+
+      pages.current = page;
+      continue;
+    }
+
+    guard.unlock();
+    page_header *page = fresh_page(size_class);
+    guard.lock();
+    pages.current = page;
+  }
+}
+
+void mature_space::clear_marks() {
+  std::lock_guard guard(pages_lock);
+  for (page_header *page : pages)
+    clear_mark_bits(page, kMarkWords);
+}
+
+void mature_space::sweep_page(page_header *page) {
+  object_metadata *free_list = nullptr;
+  object_metadata **tail = &free_list;
+  uint32_t live = 0;
+
+  for (char *cell = page->begin(); cell < page->bump; cell += page->cell_size) {
+    auto *header = reinterpret_cast<object_metadata *>(cell);
+    if (!(header->flags & object_free) && is_marked(page, header)) {
+      ++live;
+      continue;
+    }
+    header->flags = object_free;
+    *tail = header;
+    tail = &next_free(header);
+  }
+  *tail = nullptr;
+
+  size_t used = page->bump - reinterpret_cast<char *>(page);
+  clear_mark_bits(page, used / kGranuleSize / 64 + 1);
+
+  if (!live) {
+    // hand the untouched tail back to the bump allocator
+    page->bump = page->begin();
+    free_list = nullptr;
+  }
+  page->free_list = free_list;
+  page->live_cells = live;
+  page->state.store(sweep_state::swept, std::memory_order_release);
+
+  std::lock_guard guard(sweeper_lock);
+  if (--pending_pages == 0)
+    sweep_done.notify_all();
+}
+
+bool mature_space::sweep_one(size_class_pages &pages) {
+  page_header *page;
+  {
+    std::lock_guard guard(pages.lock);
+    if (pages.unswept.empty())
+      return false;
+    page = pages.unswept.back();
+    pages.unswept.pop_back();
+    page->state.store(sweep_state::sweeping, std::memory_order_relaxed);
+  }
+
+  sweep_page(page);
+
+  if (!page->live_cells) {
+    release_cells(page, page->begin());
+    std::lock_guard guard(pages_lock);
+    page->size_class = kNoSizeClass;
+    empty_pages.push_back(page);
+    return true;
+  }
+
+  // begin_sweep dropped the page being bump allocated from, whose tail past
+  // bump is still free even if every cell below it is live
+  std::lock_guard guard(pages.lock);
+  if (page->free_list || page->bump + page->cell_size <= page->limit)
+    pages.available.push_back(page);
+  return true;
+}
+
+void mature_space::begin_sweep() {
+  size_t queued = 0;
+  {
+    std::lock_guard guard(pages_lock);
+
+    for (auto &pages : classes) {
+      std::lock_guard class_guard(pages.lock);
+      pages.current = nullptr;
+      pages.available.clear();
+    }
+
+    for (page_header *page : pages) {
+      if (page->size_class == kNoSizeClass)
+        continue;
+      size_class_pages &owner = classes[page->size_class];
+      std::lock_guard class_guard(owner.lock);
+      page->state.store(sweep_state::unswept, std::memory_order_relaxed);
+      owner.unswept.push_back(page);
+      ++queued;
+    }
+  }
+
+  std::lock_guard guard(sweeper_lock);
+  pending_pages += queued;
+  sweeper_wake.notify_one();
+}
+
+void mature_space::finish_sweep() {
+  for (auto &pages : classes) {
+    while (sweep_one(pages))
+      ;
+  }
+
+  std::unique_lock guard(sweeper_lock);
+  sweep_done.wait(guard, [&] { return pending_pages == 0; });
+}
+
+void mature_space::sweeper_loop() {
+  for (;;) {
+    {
+      std::unique_lock guard(sweeper_lock);
+      sweeper_wake.wait(guard, [&] { return sweeper_exit || pending_pages; });
+      if (sweeper_exit)
+        return;
+    }
+
+    bool progress = false;
+    for (auto &pages : classes) {
+      while (sweep_one(pages))
+        progress = true;
+    }
+
+    // the remaining pages are being swept by the allocator
+    if (!progress) {
+      std::unique_lock guard(sweeper_lock);
+      sweep_done.wait(guard,
+                      [&] { return sweeper_exit || pending_pages == 0; });
+    }
+  }
+}
+
+void mature_space::plan_compaction(std::vector<object_metadata> &headers) {
+  std::lock_guard guard(pages_lock);
+  compaction_order.clear();
+  for (page_header *page : pages) {
+    if (page->size_class != kNoSizeClass)
+      compaction_order.push_back(page);
+  }
+  std::stable_sort(compaction_order.begin(), compaction_order.end(),
+                   [](page_header *a, page_header *b) {
+                     return a->size_class < b->size_class;
+                   });
+
+  compacted_bumps.resize(compaction_order.size());
+  for (size_t i = 0; i < compaction_order.size(); ++i)
+    compacted_bumps[i] = compaction_order[i]->begin();
+
+  // Cells only ever slide to an earlier place in compaction_order, so
+  // finish_compaction can move them in that order without overwriting an
+  // object that has yet to move.
+  size_t target = 0;
+  for (size_t i = 0; i < compaction_order.size(); ++i) {
+    page_header *page = compaction_order[i];
+    if (compaction_order[target]->size_class != page->size_class)
+      target = i;
+
+    for (char *cell = page->begin(); cell < page->bump;
+         cell += page->cell_size) {
+      auto *header = reinterpret_cast<object_metadata *>(cell);
+      if (!is_marked(page, header))
+        continue;
+      if (compacted_bumps[target] == compaction_order[target]->limit)
+        ++target;
+
+      auto *to = reinterpret_cast<object_metadata *>(compacted_bumps[target]);
+      compacted_bumps[target] += page->cell_size;
+      headers.push_back(*header);
+      set_forward(header, payload_of(to));
+    }
+  }
+}
+
+void mature_space::finish_compaction(
+    const std::vector<object_metadata> &headers) {
+  for_each_planned(headers, [](object_metadata *header,
+                               const object_metadata &saved) {
+    auto *to = header_of(forward_of(header));
+    std::memmove(to, header, total_size(&saved));
+    *to = saved;
+  });
+
+  std::lock_guard guard(pages_lock);
+  for (auto &pages : classes) {
+    std::lock_guard class_guard(pages.lock);
+    pages.current = nullptr;
+    pages.available.clear();
+  }
+
+  for (size_t i = 0; i < compaction_order.size(); ++i) {
+    page_header *page = compaction_order[i];
+    page->bump = compacted_bumps[i];
+    page->free_list = nullptr;
+    page->live_cells = (page->bump - page->begin()) / page->cell_size;
+    clear_mark_bits(page, kMarkWords);
+
+    if (!page->live_cells) {
+      release_cells(page, page->begin());
+      page->size_class = kNoSizeClass;
+      empty_pages.push_back(page);
+    } else if (page->bump < page->limit) {
+      release_cells(page, page->bump);
+      classes[page->size_class].available.push_back(page);
+    }
+  }
+  compaction_order.clear();
+  compacted_bumps.clear();
+}
+
+void mature_space::start_sweeper() {
+  if (sweeper.joinable())
+    return;
+  sweeper = std::thread([this] { sweeper_loop(); });
+}
+
+void mature_space::stop_sweeper() {
+  if (!sweeper.joinable())
+    return;
+  {
+    std::lock_guard guard(sweeper_lock);
+    sweeper_exit = true;
+  }
+  sweeper_wake.notify_all();
+  sweep_done.notify_all();
+  sweeper.join();
+}
+
+size_t mature_space::page_count() {
+  std::lock_guard guard(pages_lock);
+  return pages.size() - empty_pages.size();
+}
+
+size_t mature_space::mapped_bytes() {
+  std::lock_guard guard(pages_lock);
+  return (pages.size() - empty_pages.size()) * kMaturePageSize;
+}
+
+} // namespace gc
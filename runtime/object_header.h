@@ -0,0 +1,32 @@
+#ifndef RX_RUNTIME_OBJECT_HEADER_H
+#define RX_RUNTIME_OBJECT_HEADER_H
+
+#include <cstdint>
+
+// Object header ABI. Kept free of the rest of the runtime so the frontend's
+// codegen can include it for the static objects it emits, see
+// string_object.h.
+extern "C" {
+
+enum object_flags : uint8_t {
+  object_forwarded = 1 << 0,  // the header word is the new address | 1
+  object_remembered = 1 << 1, // object is in the remembered set
+  object_free = 1 << 2,       // unallocated cell of a mature page
+  object_static = 1 << 3,     // emitted into read-only data, never collected
+};
+
+// Single word header in front of every heap object. The layout is part of
+// the allocation and write barrier ABI in allocate.ll and barrier.ll, which
+// build it as `type << 32 | granules << 16` and read `flags` at payload - 8.
+// A forwarded object's header is replaced by its new payload address with
+// object_forwarded set, which is why that flag is bit 0 of the word. Mark
+// state lives in the side bitmap of the owning page, not in the header.
+struct __attribute__((aligned(8))) object_metadata {
+  uint8_t flags;
+  uint8_t age;       // minor collections survived
+  uint16_t granules; // payload size in 8 byte units, kSizeInPage if large
+  uint32_t type;     // heap map id, see register_type
+};
+}
+
+#endif
@@ -1,61 +1,25 @@
-#include "llvm-statepoint-tablegen.h"
+#include "gc.h"
+#include "runtime.h"
+#include "scheduler.h"
+#include "stackmap.h"
+#include "stats.h"
+#include "string_object.h"
+#include "trace.h"
 #include <cassert>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
-#include <iostream>
 #include <libunwind.h>
-#include <new>
-#include <unordered_set>
-#include <deque>
 
 extern "C" {
 
-extern uint8_t __LLVM_StackMaps[];
-extern int program_entry();
-statepoint_table_t *table = nullptr;
-
-enum class object_gc_state { White = 0, Gray = 1, Black = 2 };
-
-struct __attribute__((packed, aligned(8))) object_metadata {
-  uint32_t object_size;
-  object_gc_state state;
-};
-
-std::unordered_set<object_metadata *> gc_white_set;
-std::deque<void *> gc_gray_worklist;
-
-void *runtime_allocate(uint32_t size) noexcept {
-  static_assert(sizeof(object_metadata) == 8);
-
-  void *base_ptr = operator new(sizeof(object_gc_state) + size, std::nothrow);
-  assert(base_ptr && "Runtime: panic failed to allocate");
-
-  object_metadata *metadata_ptr = new (base_ptr) object_metadata{
-      .object_size = size,
-      .state = object_gc_state::White,
-  };
-  gc_white_set.insert(metadata_ptr);
-  void *obj = reinterpret_cast<char *>(base_ptr) + sizeof(object_gc_state);
-
-  std::cerr << "Runtime: allocate " << obj << " " << size << std::endl;
-  return obj;
-}
-
-void runtime_deallocate(void *ptr) noexcept {
-  static_assert(sizeof(object_metadata) == 8);
-
-  std::cerr << "Runtime: deallocate " << ptr << std::endl;
-  operator delete(reinterpret_cast<char *>(ptr) - sizeof(object_gc_state),
-                  std::nothrow);
-}
-
-void runtime_gc_poll() {
-  std::cerr << "Runtime: gc_poll" << std::endl;
-  std::cerr << "--------------------------------" << std::endl;
-  std::cerr << "  ret addr: " << __builtin_return_address(0) << " "
-            << __builtin_return_address(1) << std::endl;
-
-  std::cerr << "  stack: " << std::endl;
+// Print the calling stack with the gc roots of every statepoint frame.
+static void dump_stack() {
+  std::fprintf(stderr, "Runtime: gc_poll\n");
+  std::fprintf(stderr, "--------------------------------\n");
+  std::fprintf(stderr, "  ret addr: %p %p\n", __builtin_return_address(0),
+               __builtin_return_address(1));
+  std::fprintf(stderr, "  stack:\n");
 
   unw_cursor_t cursor;
   unw_context_t context;
@@ -74,48 +38,145 @@ void runtime_gc_poll() {
     } else {
       fprintf(stderr, "    (unknown): pc 0x%lx\n", pc);
     }
-    frame_info_t *frame_info = lookup_return_address(table, pc);
+    const gc::frame_info *frame_info = gc::statepoints.lookup(pc);
     if (frame_info) {
       char *stack_pointer = reinterpret_cast<char *>(sp);
-      char *base_pointer = stack_pointer + (frame_info->frameSize - 8);
+      char *base_pointer = stack_pointer + (frame_info->frame_size - 8);
 
-      std::cerr << "      frame: size " << frame_info->frameSize << " count "
-                << frame_info->numSlots << " sp "
-                << static_cast<void *>(stack_pointer) << " base "
-                << static_cast<void *>(base_pointer) << std::endl;
+      std::fprintf(stderr, "      frame: size %lu count %u sp %p base %p\n",
+                   static_cast<unsigned long>(frame_info->frame_size),
+                   static_cast<unsigned>(frame_info->num_slots),
+                   static_cast<void *>(stack_pointer),
+                   static_cast<void *>(base_pointer));
 
-      for (unsigned slot = 0; slot < frame_info->numSlots; ++slot) {
-        pointer_slot_t ptr_slot = frame_info->slots[slot];
+      for (unsigned slot = 0; slot < frame_info->num_slots; ++slot) {
+        gc::stack_slot ptr_slot = frame_info->slots[slot];
         char *pointer_addr = stack_pointer + ptr_slot.offset;
 
-        std::cerr << "        Live Root " << static_cast<void *>(pointer_addr)
-                  << " offset " << ptr_slot.offset << ": "
-                  << *(reinterpret_cast<void **>(pointer_addr)) << std::endl;
+        std::fprintf(stderr, "        Live Root %p offset %d: %p\n",
+                     static_cast<void *>(pointer_addr),
+                     static_cast<int>(ptr_slot.offset),
+                     *(reinterpret_cast<void **>(pointer_addr)));
       }
     }
   } while (unw_step(&cursor) > 0);
 
-  std::cerr << "--------------------------------" << std::endl << std::endl;
+  std::fprintf(stderr, "--------------------------------\n\n");
+}
+
+// Type ids for runtime_allocate_typed, registered once per type before its
+// first allocation.
+uint32_t runtime_register_type(const heap_map *map) noexcept {
+  return gc::register_type(map);
+}
+
+// Globals of a program holding gc pointers, registered by program_entry
+// before the initializers store to them. They stay roots until exit.
+void runtime_register_root(void **slot) noexcept { gc::register_root(slot); }
+
+void *runtime_allocate(uint64_t size) noexcept {
+  static_assert(sizeof(object_metadata) == 8);
+
+  void *obj = gc::allocate(size, 0);
+  RX_TRACE_EVENT(trace::kAllocations, alloc, obj, size);
+  return obj;
+}
+
+void *runtime_allocate_typed(uint64_t size, uint32_t type) noexcept {
+  void *obj = gc::allocate(size, type);
+  RX_TRACE_EVENT(trace::kAllocations, alloc, obj, size);
+  return obj;
+}
+
+// Called by the inlined fast path of allocate.ll once the thread's
+// allocation buffer cannot fit the object. May collect.
+void *runtime_allocate_slow(uint64_t size, uint32_t type) noexcept {
+  void *obj = gc::allocate(size, type);
+  RX_TRACE_EVENT(trace::kAllocations, alloc, obj, size);
+  return obj;
+}
+
+void runtime_deallocate(void *ptr) noexcept {
+  RX_TRACE_EVENT(trace::kAllocations, free, ptr, 0);
+  gc::release(ptr);
+}
+
+// Out of line slow path of the write barrier in barrier.ll, called when a
+// mature object is made to point at a nursery object.
+void runtime_remember_object(void *obj) noexcept { gc::remember_object(obj); }
+
+// The barrier of barrier.ll for code that does not link it in. That copy is
+// linkonce_odr, so a program may contain both.
+void runtime_write_barrier(void *obj, void *value) noexcept {
+  if (gc::in_nursery(value) && !gc::in_nursery(obj))
+    gc::remember_object(obj);
+}
+
+// Full collection: tenure the nursery and mark the mature heap in parallel.
+void runtime_gc_collect() {
+  gc::mark_stats stats = gc::collect_major();
+  RX_TRACE_LOG("major gc marked %zu objects %zu bytes", stats.objects,
+               stats.bytes);
+}
+
+void runtime_gc_stats(runtime_gc_stats_t *stats) noexcept {
+  gc::collect_stats(*stats);
+}
+
+// Strings, see string_object.h. Only concatenation allocates; the others
+// are gc leaves.
+void *runtime_string_concat(void *lhs, void *rhs) noexcept {
+  return str::concat(lhs, rhs);
+}
+
+bool runtime_string_equal(const void *lhs, const void *rhs) noexcept {
+  return str::equal(lhs, rhs);
+}
+
+int32_t runtime_string_compare(const void *lhs, const void *rhs) noexcept {
+  return str::compare(lhs, rhs);
+}
+
+// Lightweight tasks. `arg` may be a gc pointer.
+sched::task *runtime_spawn(void (*entry)(void *), void *arg) noexcept {
+  return sched::spawn(entry, arg);
+}
+
+void runtime_join(sched::task *task) noexcept { sched::join(task); }
+
+void runtime_detach(sched::task *task) noexcept { sched::detach(task); }
+
+void runtime_yield() noexcept { sched::yield(); }
+
+void runtime_gc_poll() {
+  if (gc::safepoint_requested.load(std::memory_order_relaxed))
+    gc::safepoint();
+
+  RX_TRACE_EVENT(trace::kAllocations, poll, __builtin_return_address(0), 0);
+  if constexpr (trace::enabled(trace::kVerbose))
+    dump_stack();
 }
 
 void runtime_inspect_ptr(void *ptr) noexcept {
-  std::cerr << "Runtime: inspect_ptr " << ptr << std::endl;
+  RX_TRACE_EVENT(trace::kAllocations, inspect, ptr, 0);
+  RX_TRACE_LOG("inspect_ptr %p", ptr);
 }
 }
 
-int main(int argc, char *argv[]) {
-  std::cerr << "Runtime: starting up runtime..." << std::endl;
+int runtime_start(int (*entry)()) {
+  trace::init();
+  RX_TRACE_LOG("starting up runtime...");
 
-  table = generate_table(__LLVM_StackMaps, 1.0);
-  print_table(stderr, table, true);
+  if constexpr (trace::enabled(trace::kVerbose))
+    gc::statepoints.print(stderr);
+  gc::init();
 
-  std::cerr << "Runtime: entering program entry" << std::endl;
+  RX_TRACE_LOG("entering program entry");
 
-  // main program
-  int rc = program_entry();
+  // main program, run as the root task
+  int rc = sched::run_main(entry);
 
-  std::cerr << "Runtime: Exit Code " << rc << std::endl;
-  destroy_table(table);
+  RX_TRACE_LOG("Exit Code %d", rc);
 
-  return 0;
+  return rc;
 }
@@ -0,0 +1,13 @@
+#ifndef RX_RUNTIME_RUNTIME_H
+#define RX_RUNTIME_RUNTIME_H
+
+extern "C" {
+
+// Starts the runtime and runs `entry` as the root task, returning its exit
+// code. The stack map sections of the program must be registered with
+// gc::statepoints before, entry.cpp does so for a linked program and the JIT
+// for every object it links.
+int runtime_start(int (*entry)());
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "scheduler.h"
+#include "gc.h"
+
+#include <algorithm>
+#include <boost/fiber/all.hpp>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sched {
+
+// compiled code may recurse deeply, so tasks get more than the default stack;
+// the mapping is committed lazily
+constexpr size_t kTaskStackSize = 1024 * 1024;
+
+struct task {
+  void (*entry)(void *);
+  void *arg; // registered as a gc root until the task starts
+  boost::fibers::fiber fiber{};
+  std::atomic<int> refs{2}; // the handle and the running fiber
+};
+
+namespace {
+
+// Guards live_tasks and shutdown. Fibers wait on it, so the condition
+// variable must be the fiber aware one.
+std::mutex pool_lock;
+boost::fibers::condition_variable_any pool_changed;
+size_t live_tasks = 0;
+bool shutdown = false;
+
+void release(task *t) {
+  if (t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete t;
+}
+
+void run(task *t) {
+  gc::enter_mutator(nullptr);
+  void *arg = t->arg;
+  gc::unregister_root(&t->arg);
+  t->entry(arg);
+  gc::leave_mutator(nullptr);
+
+  release(t);
+  {
+    std::lock_guard guard(pool_lock);
+    --live_tasks;
+  }
+  pool_changed.notify_all();
+}
+
+template <class Fn> boost::fibers::fiber launch(Fn &&fn) {
+  return boost::fibers::fiber(
+      std::allocator_arg,
+      boost::fibers::protected_fixedsize_stack(kTaskStackSize),
+      std::forward<Fn>(fn));
+}
+
+// Worker threads only run fibers: the thread's main fiber sleeps until
+// shutdown, leaving the thread to the scheduler.
+void worker_main(unsigned threads) {
+  boost::fibers::use_scheduling_algorithm<boost::fibers::algo::work_stealing>(
+      threads);
+
+  std::unique_lock guard(pool_lock);
+  pool_changed.wait(guard, [] { return shutdown; });
+}
+
+} // namespace
+
+int run_main(int (*entry)()) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  if (const char *env = std::getenv("RX_WORKERS"))
+    threads = std::max(1, std::atoi(env));
+
+  // work_stealing waits until all `threads` schedulers have registered
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < threads; ++i)
+    workers.emplace_back(worker_main, threads);
+  boost::fibers::use_scheduling_algorithm<boost::fibers::algo::work_stealing>(
+      threads);
+
+  int rc = 0;
+  boost::fibers::fiber root = launch([&] {
+    gc::enter_mutator(nullptr);
+    rc = entry();
+    gc::leave_mutator(nullptr);
+  });
+  root.join();
+
+  {
+    std::unique_lock guard(pool_lock);
+    pool_changed.wait(guard, [] { return live_tasks == 0; });
+    shutdown = true;
+  }
+  pool_changed.notify_all();
+
+  for (auto &worker : workers)
+    worker.join();
+  return rc;
+}
+
+task *spawn(void (*entry)(void *), void *arg) {
+  auto *t = new task{entry, arg};
+  gc::register_root(&t->arg);
+  {
+    std::lock_guard guard(pool_lock);
+    ++live_tasks;
+  }
+  t->fiber = launch([t] { run(t); });
+  return t;
+}
+
+void join(task *t) {
+  gc::blocking_call([&] { t->fiber.join(); });
+  release(t);
+}
+
+void detach(task *t) {
+  t->fiber.detach();
+  release(t);
+}
+
+void yield() {
+  gc::blocking_call([] { boost::this_fiber::yield(); });
+}
+
+} // namespace sched
@@ -0,0 +1,28 @@
+#ifndef RX_RUNTIME_SCHEDULER_H
+#define RX_RUNTIME_SCHEDULER_H
+
+// M:N task scheduler. Tasks are Boost.Fiber fibers multiplexed over a pool of
+// worker threads that share work through boost::fibers::algo::work_stealing.
+// Every running task is a gc mutator; a task suspended in the scheduler is
+// parked with the context of its stack so the collector can scan it.
+namespace sched {
+
+struct task;
+
+// Start the worker pool, run `entry` as the root task and wait for it and
+// every detached task before shutting the pool down. RX_WORKERS overrides the
+// number of worker threads.
+int run_main(int (*entry)());
+
+// Start `entry(arg)` as a new task. `arg` may be a gc pointer, it is kept
+// alive and relocated until the task starts. Every task must be either
+// joined or detached.
+task *spawn(void (*entry)(void *), void *arg);
+void join(task *t);
+void detach(task *t);
+
+void yield();
+
+} // namespace sched
+
+#endif
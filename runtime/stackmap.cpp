@@ -0,0 +1,237 @@
+#include "stackmap.h"
+#include "gc.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace gc {
+
+statepoint_table statepoints;
+
+namespace {
+
+enum location_kind : uint8_t {
+  location_register = 1,
+  location_direct = 2,
+  location_indirect = 3,
+  location_constant = 4,
+  location_constant_index = 5,
+};
+
+constexpr uint16_t kDwarfRbp = 6;
+constexpr uint16_t kDwarfRsp = 7;
+
+// Leading constant locations of a statepoint record: calling convention,
+// flags and the number of deopt locations that follow them.
+constexpr size_t kStatepointHeader = 3;
+
+struct location {
+  uint8_t kind;
+  uint16_t reg;
+  int32_t offset;
+};
+
+struct function_record {
+  uint64_t address;
+  uint64_t stack_size;
+  uint64_t record_count;
+};
+
+class section_reader {
+public:
+  explicit section_reader(const uint8_t *section) : cursor(section) {}
+
+  template <class T> T read() {
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+  }
+
+  void skip(size_t bytes) { cursor += bytes; }
+
+  // the section itself is 8 byte aligned
+  void align() {
+    cursor = reinterpret_cast<const uint8_t *>(
+        align_up(reinterpret_cast<uintptr_t>(cursor), 8));
+  }
+
+private:
+  const uint8_t *cursor;
+};
+
+// Offset of a spilled gc pointer from the stack pointer at the return
+// address. Pointers that are not on the stack, e.g. null constants, have no
+// slot to update.
+bool stack_offset(const location &loc, const function_record &function,
+                  int32_t &offset) {
+  if (loc.kind != location_indirect)
+    return false;
+  if (loc.reg == kDwarfRsp) {
+    offset = loc.offset;
+    return true;
+  }
+  if (loc.reg == kDwarfRbp) {
+    // the frame pointer sits below the return address and the saved rbp
+    offset = static_cast<int32_t>(function.stack_size - 8) + loc.offset;
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+void statepoint_table::add_stackmaps(const uint8_t *section) {
+  std::lock_guard guard(lock);
+  // the objects of a program linked from several modules at the IR level
+  // all name the same section
+  if (std::find(sections.begin(), sections.end(), section) != sections.end())
+    return;
+  sections.push_back(section);
+  stale.store(true, std::memory_order_release);
+}
+
+void statepoint_table::parse(const uint8_t *section) {
+  section_reader in(section);
+
+  uint8_t version = in.read<uint8_t>();
+  if (version != 3) {
+    trace::log("panic unsupported stack map version %u", version);
+    std::abort();
+  }
+  in.skip(3);
+
+  uint32_t num_functions = in.read<uint32_t>();
+  uint32_t num_constants = in.read<uint32_t>();
+  uint32_t num_records = in.read<uint32_t>();
+
+  std::vector<function_record> functions(num_functions);
+  for (function_record &function : functions)
+    function = in.read<function_record>();
+  in.skip(num_constants * sizeof(uint64_t));
+
+  std::vector<location> locations;
+  size_t function = 0;
+  uint64_t remaining = num_functions ? functions[0].record_count : 0;
+
+  for (uint32_t record = 0; record < num_records; ++record) {
+    while (!remaining)
+      remaining = functions[++function].record_count;
+    --remaining;
+
+    in.skip(sizeof(uint64_t)); // patch point id
+    uint32_t instruction_offset = in.read<uint32_t>();
+    in.skip(sizeof(uint16_t)); // flags
+    uint16_t num_locations = in.read<uint16_t>();
+
+    locations.resize(num_locations);
+    for (location &loc : locations) {
+      loc.kind = in.read<uint8_t>();
+      in.skip(sizeof(uint8_t) + sizeof(uint16_t)); // reserved, size
+      loc.reg = in.read<uint16_t>();
+      in.skip(sizeof(uint16_t));
+      loc.offset = in.read<int32_t>();
+    }
+    in.align();
+    in.skip(sizeof(uint16_t));
+    uint16_t num_live_outs = in.read<uint16_t>();
+    in.skip(num_live_outs * sizeof(uint32_t));
+    in.align();
+
+    const function_record &owner = functions[function];
+    size_t first_slot = slots.size();
+    frames.push_back({owner.address + instruction_offset, owner.stack_size, 0,
+                      reinterpret_cast<const stack_slot *>(first_slot)});
+
+    if (num_locations < kStatepointHeader ||
+        locations[2].kind != location_constant)
+      continue;
+
+    // the rest are (base, derived) pairs of relocated gc pointers
+    auto find_slot = [&](int32_t kind, int32_t offset) -> int32_t {
+      for (size_t idx = first_slot; idx < slots.size(); ++idx) {
+        if (slots[idx].kind == kind && slots[idx].offset == offset)
+          return static_cast<int32_t>(idx - first_slot);
+      }
+      slots.push_back({kind, offset});
+      return static_cast<int32_t>(slots.size() - 1 - first_slot);
+    };
+
+    size_t begin = kStatepointHeader + locations[2].offset;
+    for (size_t idx = begin; idx + 1 < locations.size(); idx += 2) {
+      int32_t base_offset, derived_offset;
+      if (!stack_offset(locations[idx], owner, base_offset))
+        continue;
+      int32_t base = find_slot(-1, base_offset);
+      if (stack_offset(locations[idx + 1], owner, derived_offset) &&
+          derived_offset != base_offset)
+        find_slot(base, derived_offset);
+    }
+    frames.back().num_slots = static_cast<uint32_t>(slots.size() - first_slot);
+  }
+}
+
+void statepoint_table::rebuild() {
+  std::lock_guard guard(lock);
+  if (!stale.load(std::memory_order_relaxed))
+    return;
+
+  frames.clear();
+  slots.clear();
+  for (const uint8_t *section : sections)
+    parse(section);
+
+  // slots are stored by index while the vector grows
+  for (frame_info &frame : frames)
+    frame.slots = slots.data() + reinterpret_cast<uintptr_t>(frame.slots);
+
+  size_t capacity = 2;
+  shift = 63;
+  while (capacity < 2 * frames.size()) {
+    capacity *= 2;
+    --shift;
+  }
+  mask = capacity - 1;
+  keys.assign(capacity, 0);
+  values.assign(capacity, 0);
+
+  for (uint32_t idx = 0; idx < frames.size(); ++idx) {
+    uintptr_t key = frames[idx].return_address;
+    size_t bucket = hash(key);
+    while (keys[bucket] && keys[bucket] != key)
+      bucket = (bucket + 1) & mask;
+    keys[bucket] = key;
+    values[bucket] = idx;
+  }
+
+  stale.store(false, std::memory_order_release);
+}
+
+size_t statepoint_table::size() {
+  if (stale.load(std::memory_order_acquire))
+    rebuild();
+  return frames.size();
+}
+
+void statepoint_table::print(FILE *out) {
+  std::fprintf(out, "statepoint table: %zu frames in %zu buckets\n", size(),
+               keys.size());
+  for (const frame_info &frame : frames) {
+    std::fprintf(out, "  return address %#lx frame size %lu slots %u\n",
+                 static_cast<unsigned long>(frame.return_address),
+                 static_cast<unsigned long>(frame.frame_size),
+                 frame.num_slots);
+    for (uint32_t idx = 0; idx < frame.num_slots; ++idx) {
+      const stack_slot &slot = frame.slots[idx];
+      if (slot.kind < 0)
+        std::fprintf(out, "    base    sp + %d\n", slot.offset);
+      else
+        std::fprintf(out, "    derived sp + %d from slot %d\n", slot.offset,
+                     slot.kind);
+    }
+  }
+}
+
+} // namespace gc
@@ -0,0 +1,79 @@
+#ifndef RX_RUNTIME_STACKMAP_H
+#define RX_RUNTIME_STACKMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace gc {
+
+// A gc pointer spilled in a statepoint frame. `offset` is relative to the
+// stack pointer at the return address. Base pointers have kind -1, derived
+// pointers hold the index of their base slot in the same frame.
+struct stack_slot {
+  int32_t kind;
+  int32_t offset;
+};
+
+struct frame_info {
+  uintptr_t return_address;
+  uint64_t frame_size;
+  uint32_t num_slots;
+  const stack_slot *slots;
+};
+
+// Statepoint frames of the program keyed by return address. Sections in the
+// LLVM StackMap v3 format are registered up front but only parsed on the
+// first lookup, i.e. the first collection, and then indexed in an open
+// addressing table with linear probing so a lookup is usually a single
+// cache line.
+class statepoint_table {
+public:
+  void add_stackmaps(const uint8_t *section);
+
+  const frame_info *lookup(uintptr_t return_address) {
+    if (stale.load(std::memory_order_acquire))
+      rebuild();
+
+    for (size_t idx = hash(return_address);; idx = (idx + 1) & mask) {
+      uintptr_t key = keys[idx];
+      if (!key)
+        return nullptr;
+      if (key == return_address)
+        return &frames[values[idx]];
+    }
+  }
+
+  size_t size();
+  void print(FILE *out);
+
+private:
+  size_t hash(uintptr_t key) const {
+    return (key * 0x9e3779b97f4a7c15ull) >> shift;
+  }
+
+  void rebuild();
+  void parse(const uint8_t *section);
+
+private:
+  std::mutex lock;
+  std::atomic<bool> stale{false};
+  std::vector<const uint8_t *> sections;
+
+  std::vector<frame_info> frames;
+  std::vector<stack_slot> slots;
+
+  // empty until the first rebuild, keys of 0 are free buckets
+  std::vector<uintptr_t> keys = {0, 0};
+  std::vector<uint32_t> values = {0, 0};
+  size_t mask = 1;
+  unsigned shift = 63;
+};
+
+extern statepoint_table statepoints;
+
+} // namespace gc
+
+#endif
@@ -0,0 +1,115 @@
+#include "stats.h"
+#include "gc.h"
+
+#include <algorithm>
+
+namespace gc {
+
+namespace {
+
+std::array<pause_histogram, runtime_gc_phase_count> pauses;
+std::chrono::steady_clock::time_point start_time =
+    std::chrono::steady_clock::now();
+
+const char *phase_name(int phase) {
+  switch (phase) {
+  case runtime_gc_phase_minor:
+    return "minor";
+  case runtime_gc_phase_root_scan:
+    return "root scan";
+  case runtime_gc_phase_mark:
+    return "mark";
+  case runtime_gc_phase_sweep:
+    return "sweep";
+  case runtime_gc_phase_compact:
+    return "compact";
+  case runtime_gc_phase_major:
+    return "major";
+  }
+  return "?";
+}
+
+} // namespace
+
+uint64_t pause_histogram::value_at_percentile(double percentile) const {
+  if (!total_count)
+    return 0;
+
+  auto wanted = static_cast<uint64_t>(percentile / 100.0 * total_count + 0.5);
+  if (wanted < 1)
+    wanted = 1;
+
+  uint64_t seen = 0;
+  for (size_t idx = 0; idx < counts.size(); ++idx) {
+    seen += counts[idx];
+    if (seen >= wanted)
+      return std::min(highest_in(idx), max_value);
+  }
+  return max_value;
+}
+
+void record_pause(runtime_gc_phase phase, uint64_t nanoseconds) {
+  pauses[phase].record(nanoseconds);
+}
+
+pause_timer::~pause_timer() {
+  record_pause(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+}
+
+void reset_stats() {
+  pauses = {};
+  start_time = std::chrono::steady_clock::now();
+}
+
+void collect_stats(runtime_gc_stats_t &out) {
+  heap_usage heap = usage();
+  out.allocated_bytes = heap.allocated_bytes;
+  out.live_bytes = heap.live_bytes;
+  out.heap_bytes = heap.heap_bytes;
+  out.minor_collections = minor_collections();
+  out.major_collections = major_collections();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  out.allocation_rate = seconds > 0 ? heap.allocated_bytes / seconds : 0;
+
+  for (int phase = 0; phase < runtime_gc_phase_count; ++phase) {
+    const pause_histogram &histogram = pauses[phase];
+    out.pauses[phase] = {histogram.count(),
+                         histogram.sum(),
+                         histogram.value_at_percentile(50),
+                         histogram.value_at_percentile(90),
+                         histogram.value_at_percentile(99),
+                         histogram.max()};
+  }
+}
+
+void print_stats(FILE *out) {
+  runtime_gc_stats_t stats;
+  collect_stats(stats);
+
+  constexpr double kMiB = 1024.0 * 1024.0;
+  std::fprintf(out, "gc stats\n");
+  std::fprintf(out, "  allocated   %12.1f MiB (%.1f MiB/s)\n",
+               stats.allocated_bytes / kMiB, stats.allocation_rate / kMiB);
+  std::fprintf(out, "  live        %12.1f MiB\n", stats.live_bytes / kMiB);
+  std::fprintf(out, "  heap        %12.1f MiB\n", stats.heap_bytes / kMiB);
+  std::fprintf(out, "  collections %12lu minor %lu major\n",
+               static_cast<unsigned long>(stats.minor_collections),
+               static_cast<unsigned long>(stats.major_collections));
+
+  std::fprintf(out, "  %-10s %8s %10s %10s %10s %10s %10s\n", "pause (us)",
+               "count", "total", "p50", "p90", "p99", "max");
+  for (int phase = 0; phase < runtime_gc_phase_count; ++phase) {
+    const runtime_gc_pause_stats &pause = stats.pauses[phase];
+    std::fprintf(out, "  %-10s %8lu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                 phase_name(phase), static_cast<unsigned long>(pause.count),
+                 pause.total / 1e3, pause.p50 / 1e3, pause.p90 / 1e3,
+                 pause.p99 / 1e3, pause.max / 1e3);
+  }
+}
+
+} // namespace gc
@@ -0,0 +1,123 @@
+#ifndef RX_RUNTIME_STATS_H
+#define RX_RUNTIME_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+extern "C" {
+
+enum runtime_gc_phase {
+  runtime_gc_phase_minor,      // nursery evacuation
+  runtime_gc_phase_root_scan,  // stack and global roots of a major gc
+  runtime_gc_phase_mark,
+  runtime_gc_phase_sweep,      // finishing the last cycle, queueing pages
+  runtime_gc_phase_compact,    // sliding the mature heap, RX_GC_MODE=compact
+  runtime_gc_phase_major,      // whole major pause
+  runtime_gc_phase_count,
+};
+
+// Pause times in nanoseconds, quantiles have about 1% relative error.
+struct runtime_gc_pause_stats {
+  uint64_t count;
+  uint64_t total;
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+  uint64_t max;
+};
+
+struct runtime_gc_stats_t {
+  uint64_t allocated_bytes; // since startup
+  uint64_t live_bytes;      // estimate, exact right after a major gc
+  uint64_t heap_bytes;      // nursery plus mapped mature pages
+  uint64_t minor_collections;
+  uint64_t major_collections;
+  double allocation_rate; // bytes per second since startup
+  runtime_gc_pause_stats pauses[runtime_gc_phase_count];
+};
+}
+
+namespace gc {
+
+// Log-linear histogram in the style of HdrHistogram: values below 128 get a
+// bucket each, above that every power of two range is split into 64 buckets,
+// which bounds the relative error of a recorded value by 1/64.
+class pause_histogram {
+public:
+  void record(uint64_t value) {
+    ++counts[index_of(value)];
+    ++total_count;
+    total_sum += value;
+    if (value > max_value)
+      max_value = value;
+  }
+
+  uint64_t count() const { return total_count; }
+  uint64_t sum() const { return total_sum; }
+  uint64_t max() const { return max_value; }
+
+  // Smallest recorded bucket bound with at least `percentile` percent of the
+  // values at or below it.
+  uint64_t value_at_percentile(double percentile) const;
+
+private:
+  static constexpr unsigned kSubBucketBits = 7;
+  static constexpr unsigned kHalfBucket = 1 << (kSubBucketBits - 1);
+  static constexpr unsigned kRanges = 64 - kSubBucketBits + 2;
+
+  static size_t index_of(uint64_t value) {
+    unsigned range = 0;
+    if (value >> kSubBucketBits)
+      range = 64 - __builtin_clzll(value) - kSubBucketBits;
+    return range * kHalfBucket + (value >> range);
+  }
+
+  static uint64_t highest_in(size_t index) {
+    unsigned range = index < 2 * kHalfBucket ? 0 : index / kHalfBucket - 1;
+    uint64_t lowest = (index - range * kHalfBucket) << range;
+    return lowest + (uint64_t(1) << range) - 1;
+  }
+
+private:
+  std::array<uint64_t, kRanges * kHalfBucket> counts = {};
+  uint64_t total_count = 0;
+  uint64_t total_sum = 0;
+  uint64_t max_value = 0;
+};
+
+// Pauses are only recorded by the collector while the world is stopped.
+void record_pause(runtime_gc_phase phase, uint64_t nanoseconds);
+
+template <class Fn> uint64_t time_nanoseconds(Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Records the time until the end of the scope as a pause of `phase`.
+class pause_timer {
+public:
+  explicit pause_timer(runtime_gc_phase phase)
+      : phase(phase), start(std::chrono::steady_clock::now()) {}
+  ~pause_timer();
+
+private:
+  runtime_gc_phase phase;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Starts the clock of the allocation rate.
+void reset_stats();
+
+void collect_stats(runtime_gc_stats_t &out);
+
+// Table of the current statistics, printed at exit with RX_GC_STATS=1.
+void print_stats(FILE *out);
+
+} // namespace gc
+
+#endif
@@ -0,0 +1,99 @@
+#include "string_object.h"
+#include "gc.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace str {
+
+namespace {
+
+// Index of the first of the `n` bytes where `a` and `b` differ, or `n`.
+// Compares 16 bytes at a time and never reads past either range.
+size_t mismatch(const char *a, const char *b, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    unsigned differ = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffff;
+    if (differ)
+      return i + __builtin_ctz(differ);
+  }
+#endif
+  for (; i < n; ++i)
+    if (a[i] != b[i])
+      return i;
+  return n;
+}
+
+// Payload of a zeroed string object for `length` bytes. The allocation may
+// collect and move the operands the caller copies from afterwards, which
+// are only rooted when it cannot be served without collecting.
+void *allocate(uint64_t length, void *&lhs, void *&rhs) {
+  size_t size = payload_size(length);
+  void *s = gc::try_allocate(size, 0);
+  if (!s) {
+    gc::register_root(&lhs);
+    gc::register_root(&rhs);
+    s = gc::allocate(size, 0);
+    gc::unregister_root(&rhs);
+    gc::unregister_root(&lhs);
+  }
+
+  if (length <= kMaxShortLength) {
+    *static_cast<uint8_t *>(s) = short_tag(length);
+  } else {
+    *static_cast<uint64_t *>(s) = long_tag(length);
+  }
+  return s;
+}
+
+} // namespace
+
+void *concat(void *lhs, void *rhs) {
+  uint64_t lhs_length = length(lhs);
+  uint64_t rhs_length = length(rhs);
+  // strings are immutable, so the other side is the result
+  if (!rhs_length)
+    return lhs;
+  if (!lhs_length)
+    return rhs;
+
+  void *s = allocate(lhs_length + rhs_length, lhs, rhs);
+  // the bytes were zeroed, which terminates them
+  char *bytes = const_cast<char *>(data(s));
+  std::memcpy(bytes, data(lhs), lhs_length);
+  std::memcpy(bytes + lhs_length, data(rhs), rhs_length);
+  return s;
+}
+
+bool equal(const void *lhs, const void *rhs) {
+  if (lhs == rhs)
+    return true;
+  // the length byte, the bytes and the zero padding at once
+  if (lhs && rhs && is_short(lhs) && is_short(rhs))
+    return mismatch(static_cast<const char *>(lhs),
+                    static_cast<const char *>(rhs), kShortSize) == kShortSize;
+
+  uint64_t n = length(lhs);
+  return n == length(rhs) && mismatch(data(lhs), data(rhs), n) == n;
+}
+
+int compare(const void *lhs, const void *rhs) {
+  uint64_t lhs_length = length(lhs);
+  uint64_t rhs_length = length(rhs);
+  uint64_t n = std::min(lhs_length, rhs_length);
+  const char *a = data(lhs);
+  const char *b = data(rhs);
+  size_t i = mismatch(a, b, n);
+  if (i < n)
+    return static_cast<unsigned char>(a[i]) - static_cast<unsigned char>(b[i]);
+  return (lhs_length > rhs_length) - (lhs_length < rhs_length);
+}
+
+} // namespace str
@@ -0,0 +1,73 @@
+#ifndef RX_RUNTIME_STRING_OBJECT_H
+#define RX_RUNTIME_STRING_OBJECT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// String ABI, shared with the frontend's codegen of `string`.
+//
+// Strings are immutable. A string value is a single reference to the payload
+// of a string object, so statepoints relocate it like any other gc pointer,
+// and null reads as the empty string, which is what zeroed fields hold. The
+// payload has one of two forms, told apart by bit 0 of its first byte:
+//
+//   short, up to kMaxShortLength bytes: a byte holding length << 1 | 1, the
+//   bytes and a NUL, zero padded to kShortSize. A short string fits the
+//   smallest size class, and two short strings are equal iff their payloads
+//   are.
+//
+//   long: a word holding length << 1, followed by the bytes and a NUL.
+//
+// Either way the length is read in O(1). String objects hold no gc pointers
+// and are allocated with type 0. Literals are not allocated at all: the
+// frontend emits their whole object, the header of object_header.h included,
+// into read-only data with object_static set, and one object for equal
+// literals. It includes this header for the constants below, so they must
+// not depend on the rest of the runtime.
+namespace str {
+
+constexpr size_t kShortSize = 24;
+constexpr size_t kMaxShortLength = kShortSize - 2;
+constexpr size_t kLongDataOffset = 8;
+
+// First byte of a short payload and first word of a long one.
+constexpr uint8_t short_tag(uint64_t length) {
+  return static_cast<uint8_t>(length << 1 | 1);
+}
+constexpr uint64_t long_tag(uint64_t length) { return length << 1; }
+
+inline bool is_short(const void *s) {
+  return *static_cast<const uint8_t *>(s) & 1;
+}
+
+inline uint64_t length(const void *s) {
+  if (!s)
+    return 0;
+  if (is_short(s))
+    return *static_cast<const uint8_t *>(s) >> 1;
+  return *static_cast<const uint64_t *>(s) >> 1;
+}
+
+inline const char *data(const void *s) {
+  if (!s)
+    return "";
+  return static_cast<const char *>(s) + (is_short(s) ? 1 : kLongDataOffset);
+}
+
+// Payload size of a string of `length` bytes.
+constexpr size_t payload_size(uint64_t length) {
+  return length <= kMaxShortLength ? kShortSize
+                                   : kLongDataOffset + length + 1;
+}
+
+// Concatenation. Allocates unless one side is empty, so it may collect.
+void *concat(void *lhs, void *rhs);
+
+bool equal(const void *lhs, const void *rhs);
+
+// Orders by the bytes as unsigned chars, a prefix first: <0, 0 or >0.
+int compare(const void *lhs, const void *rhs);
+
+} // namespace str
+
+#endif
@@ -1,11 +1,18 @@
 #!/usr/bin/env bash
 
-opt -S -passes='function(place-safepoints),module(rewrite-statepoints-for-gc)' add.ll -o add.opt.ll
+# With PASSES_DIR pointing at a build of compiler/passes, polls and live gc
+# pointers are trimmed before the statepoints are rewritten.
+PLUGINS=()
+PIPELINE='function(place-safepoints),module(rewrite-statepoints-for-gc)'
+if [ -n "$PASSES_DIR" ]; then
+    PLUGINS=(-load-pass-plugin="$PASSES_DIR/SafepointPass.so")
+    PIPELINE='function(place-safepoints,gc-safepoint-opt),module(rewrite-statepoints-for-gc)'
+fi
+
+opt -S "${PLUGINS[@]}" -passes="$PIPELINE" add.ll -o add.opt.ll
 llc --filetype=obj -O3 add.opt.ll -o add.o
 llc --filetype=asm --x86-asm-syntax=intel -O3 add.opt.ll -o add.s
 
-opt -S -passes='function(place-safepoints),module(rewrite-statepoints-for-gc)' main.ll -o main.opt.ll
+opt -S "${PLUGINS[@]}" -passes="$PIPELINE" main.ll -o main.opt.ll
 llc --filetype=obj -O3 main.opt.ll -o main.o
 llc --filetype=asm --x86-asm-syntax=intel -O3 main.opt.ll -o main.s
-
-
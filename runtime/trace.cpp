@@ -0,0 +1,112 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace trace {
+
+namespace {
+
+#if RX_TRACE_LEVEL > 0
+event ring[kTraceCapacity];
+std::atomic<uint64_t> head{0};
+std::atomic<uint16_t> thread_count{0};
+thread_local uint16_t thread_id =
+    thread_count.fetch_add(1, std::memory_order_relaxed);
+
+// copied out of the environment up front, dump runs in signal handlers
+char trace_path[4096] = "rx-trace.bin";
+
+void write_all(int fd, const void *data, size_t size) {
+  auto *bytes = static_cast<const char *>(data);
+  while (size) {
+    ssize_t written = ::write(fd, bytes, size);
+    if (written <= 0)
+      return;
+    bytes += written;
+    size -= written;
+  }
+}
+
+void dump_on_signal(int) { dump(); }
+#endif
+
+} // namespace
+
+void init() {
+#if RX_TRACE_LEVEL > 0
+  if (const char *path = std::getenv("RX_TRACE_FILE"))
+    std::strncpy(trace_path, path, sizeof(trace_path) - 1);
+
+  std::atexit(dump);
+
+  struct sigaction action = {};
+  action.sa_handler = dump_on_signal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, nullptr);
+#endif
+}
+
+void record(event_kind kind, uint64_t a, uint32_t b) {
+#if RX_TRACE_LEVEL > 0
+  uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+  event &slot = ring[index % kTraceCapacity];
+
+  std::atomic_ref<uint64_t> sequence(slot.sequence);
+  sequence.store(0, std::memory_order_relaxed);
+  slot.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  slot.a = a;
+  slot.b = b;
+  slot.thread = thread_id;
+  slot.kind = kind;
+  sequence.store(index + 1, std::memory_order_release);
+#else
+  (void)kind, (void)a, (void)b;
+#endif
+}
+
+// Records still being written when the dump runs have sequence 0.
+void dump() {
+#if RX_TRACE_LEVEL > 0
+  int fd = ::open(trace_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return;
+
+  uint64_t end = head.load(std::memory_order_acquire);
+  uint64_t begin = end > kTraceCapacity ? end - kTraceCapacity : 0;
+
+  file_header header = {{'R', 'X', 'T', 'R', 'A', 'C', 'E', '1'},
+                        sizeof(event),
+                        static_cast<uint32_t>(end - begin)};
+  write_all(fd, &header, sizeof(header));
+
+  // oldest first: the tail of the ring, then its wrapped head
+  size_t first = begin % kTraceCapacity;
+  size_t count = end - begin;
+  size_t tail = count < kTraceCapacity - first ? count : kTraceCapacity - first;
+  write_all(fd, ring + first, tail * sizeof(event));
+  write_all(fd, ring, (count - tail) * sizeof(event));
+  ::close(fd);
+#endif
+}
+
+void log(const char *format, ...) {
+  char line[1024];
+  va_list args;
+  va_start(args, format);
+  std::vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  std::fprintf(stderr, "Runtime: %s\n", line);
+}
+
+} // namespace trace
@@ -0,0 +1,95 @@
+#ifndef RX_RUNTIME_TRACE_H
+#define RX_RUNTIME_TRACE_H
+
+#include <cstdint>
+
+// Runtime tracing, selected at compile time with RX_TRACE_LEVEL:
+//   0 - nothing, every trace point compiles away (default)
+//   1 - gc phase events
+//   2 - plus allocation, free and poll events
+//   3 - plus human readable logging to stderr (stack dumps, statepoint table)
+//
+// Events go to a lock-free ring buffer holding the most recent
+// kTraceCapacity events. It is written to RX_TRACE_FILE (rx-trace.bin by
+// default) at exit and whenever the process receives SIGUSR1. The dump is a
+// trace::file_header followed by `count` trace::event records, oldest first.
+#ifndef RX_TRACE_LEVEL
+#define RX_TRACE_LEVEL 0
+#endif
+
+namespace trace {
+
+constexpr int kPhases = 1;
+constexpr int kAllocations = 2;
+constexpr int kVerbose = 3;
+
+constexpr bool enabled(int level) { return RX_TRACE_LEVEL >= level; }
+
+enum class event_kind : uint8_t {
+  alloc,       // a = object, b = payload size
+  free,        // a = object
+  poll,        // a = return address
+  inspect,     // a = pointer
+  phase_begin, // a = gc_phase
+  phase_end,   // a = gc_phase, b = phase specific count
+};
+
+enum class gc_phase : uint8_t {
+  minor,
+  major,
+  roots,
+  mark,
+  sweep,
+  compact,
+};
+
+struct event {
+  uint64_t sequence; // 1 + index of the event, 0 while being written
+  uint64_t timestamp; // steady clock nanoseconds
+  uint64_t a;
+  uint32_t b;
+  uint16_t thread;
+  event_kind kind;
+  uint8_t reserved;
+};
+
+struct file_header {
+  char magic[8]; // "RXTRACE1"
+  uint32_t event_size;
+  uint32_t count;
+};
+
+constexpr uint32_t kTraceCapacity = 1 << 16;
+
+void init();
+void record(event_kind kind, uint64_t a, uint32_t b);
+
+// Write the ring buffer to the trace file. Async-signal-safe.
+void dump();
+
+// printf style line to stderr, prefixed with "Runtime: ".
+void log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+} // namespace trace
+
+// Trace points. Arguments are not evaluated unless the level is enabled.
+#define RX_TRACE_EVENT(level, kind, a, b)                                      \
+  do {                                                                         \
+    if constexpr (::trace::enabled(level))                                     \
+      ::trace::record(::trace::event_kind::kind, (uint64_t)(a),                \
+                      (uint32_t)(b));                                          \
+  } while (0)
+
+#define RX_TRACE_PHASE_BEGIN(phase)                                            \
+  RX_TRACE_EVENT(::trace::kPhases, phase_begin, ::trace::gc_phase::phase, 0)
+
+#define RX_TRACE_PHASE_END(phase, count)                                       \
+  RX_TRACE_EVENT(::trace::kPhases, phase_end, ::trace::gc_phase::phase, count)
+
+#define RX_TRACE_LOG(...)                                                      \
+  do {                                                                         \
+    if constexpr (::trace::enabled(::trace::kVerbose))                         \
+      ::trace::log(__VA_ARGS__);                                               \
+  } while (0)
+
+#endif
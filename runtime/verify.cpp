@@ -0,0 +1,138 @@
+#include "gc.h"
+#include "trace.h"
+
+#include <cstdlib>
+
+namespace gc {
+
+namespace {
+
+[[noreturn]] void fail(const char *what, const void *obj) {
+  trace::log("panic heap verification failed: %s at %p", what, obj);
+  std::abort();
+}
+
+void check_header(const object_metadata *header, uint8_t allowed_flags) {
+  const void *obj = header + 1;
+  if (is_forwarded(header))
+    fail("forwarded object", obj);
+  if (header->flags & ~allowed_flags)
+    fail("unexpected header flags", obj);
+  if (header->age > kPromotionAge)
+    fail("age past promotion", obj);
+  if (header->type >= type_count())
+    fail("unregistered type", obj);
+
+  if (header->granules == kSizeInPage) {
+    page_header *page = heap_pages.page_of(header);
+    if (!page || !page->is_large() ||
+        page->begin() != reinterpret_cast<const char *>(header))
+      fail("large object outside its page", obj);
+  } else if (sizeof(object_metadata) + header->granules * size_t(8) >
+             kMaxSmallSize) {
+    fail("small object past the largest size class", obj);
+  }
+}
+
+// Checks that `ptr` is null or points to the payload of a valid object. With
+// `marked`, mature targets must be marked as well.
+void check_reference(void *ptr, bool marked) {
+  if (!ptr)
+    return;
+  if (young.eden.contains(ptr) || young.to.contains(ptr))
+    fail("pointer into an evacuated space", ptr);
+
+  object_metadata *header = header_of(ptr);
+  if (young.from.contains(ptr)) {
+    if (reinterpret_cast<char *>(header) < young.from.start ||
+        reinterpret_cast<char *>(ptr) >= young.from.cursor)
+      fail("pointer past the survivors", ptr);
+    check_header(header, 0);
+    return;
+  }
+
+  page_header *page = heap_pages.page_of(ptr);
+  if (!page) {
+    // string literals live in the read-only data of the program
+    if (!(header->flags & object_static))
+      fail("pointer outside the heap", ptr);
+    return;
+  }
+  auto *cell = reinterpret_cast<char *>(header);
+  if (page->is_large() ? cell != page->begin()
+                       : cell >= page->bump ||
+                             (cell - page->begin()) % page->cell_size)
+    fail("pointer between objects", ptr);
+  if (header->flags & object_free)
+    fail("pointer to a free cell", ptr);
+  check_header(header, object_remembered);
+  if (marked && !mature_space::is_marked(page, header))
+    fail("marked object points to an unmarked one", ptr);
+}
+
+void check_fields(object_metadata *header, bool marked) {
+  const heap_map *map = map_of(header);
+  if (!map)
+    return;
+
+  char *payload = static_cast<char *>(payload_of(header));
+  size_t size = total_size(header) - sizeof(object_metadata);
+  for (uint32_t i = 0; i < map->num_offsets; ++i) {
+    if (map->offsets[i] + sizeof(void *) > size)
+      fail("pointer map past the object", payload);
+    check_reference(*reinterpret_cast<void **>(payload + map->offsets[i]),
+                    marked);
+  }
+}
+
+// Roots may also hold addresses outside the heap, e.g. of objects that
+// escape analysis moved to the stack.
+void check_root(void *ptr, bool marked) {
+  if (ptr && (in_nursery(ptr) || heap_pages.page_of(ptr)))
+    check_reference(ptr, marked);
+}
+
+} // namespace
+
+void verify_young(const std::vector<object_metadata *> &remembered,
+                  const std::vector<void **> &roots) {
+  if (young.eden.used())
+    fail("eden not empty after a minor collection", young.eden.start);
+
+  for (char *scan = young.from.start; scan < young.from.cursor;) {
+    auto *header = reinterpret_cast<object_metadata *>(scan);
+    check_header(header, 0);
+    check_fields(header, false);
+    scan += total_size(header);
+  }
+
+  for (object_metadata *header : remembered) {
+    if (!(header->flags & object_remembered))
+      fail("remembered object without its flag", payload_of(header));
+    check_reference(payload_of(header), false);
+    check_fields(header, false);
+  }
+
+  for (void **root : roots)
+    check_root(*root, false);
+}
+
+void verify_mature(const std::vector<void *> &roots, bool marked) {
+  if (young.eden.used() || young.from.used())
+    fail("nursery not empty after tenuring", young.eden.start);
+
+  auto check = [marked](page_header *page, object_metadata *header) {
+    check_header(header, object_remembered);
+    if (!marked)
+      check_fields(header, false);
+    else if (mature_space::is_marked(page, header))
+      check_fields(header, true);
+  };
+  mature.for_each_object(check);
+  large.for_each_object(check);
+
+  for (void *root : roots)
+    check_root(root, marked);
+}
+
+} // namespace gc
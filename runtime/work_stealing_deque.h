@@ -0,0 +1,121 @@
+#ifndef RX_RUNTIME_WORK_STEALING_DEQUE_H
+#define RX_RUNTIME_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace gc {
+
+// Chase-Lev work-stealing deque, following "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (Le et al., PPoPP'13). The owner
+// pushes and pops at the bottom, thieves steal from the top. Grown rings are
+// retired rather than freed so that in-flight thieves never read freed
+// memory; they are released with the deque.
+template <class T> class work_stealing_deque {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  struct ring {
+    explicit ring(int64_t capacity)
+        : capacity(capacity), items(new std::atomic<T>[capacity]) {}
+
+    T get(int64_t idx) const {
+      return items[idx & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t idx, T value) {
+      items[idx & (capacity - 1)].store(value, std::memory_order_relaxed);
+    }
+
+    int64_t capacity;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+public:
+  explicit work_stealing_deque(int64_t capacity = 1024) {
+    rings.push_back(std::make_unique<ring>(capacity));
+    buffer.store(rings.back().get(), std::memory_order_relaxed);
+  }
+
+  work_stealing_deque(const work_stealing_deque &) = delete;
+  work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+  // owner only
+  void push(T value) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    ring *a = buffer.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1)
+      a = grow(a, b, t);
+    a->put(b, value);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // owner only
+  bool pop(T &out) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    ring *a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    out = a->get(b);
+    if (t != b)
+      return true;
+
+    // last element, race against thieves for it
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  // any thread
+  bool steal(T &out) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+      return false;
+
+    ring *a = buffer.load(std::memory_order_acquire);
+    out = a->get(t);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    int64_t b = bottom.load(std::memory_order_acquire);
+    int64_t t = top.load(std::memory_order_acquire);
+    return t >= b;
+  }
+
+private:
+  ring *grow(ring *old, int64_t b, int64_t t) {
+    auto bigger = std::make_unique<ring>(old->capacity * 2);
+    for (int64_t i = t; i < b; ++i)
+      bigger->put(i, old->get(i));
+    ring *result = bigger.get();
+    rings.push_back(std::move(bigger));
+    buffer.store(result, std::memory_order_release);
+    return result;
+  }
+
+private:
+  alignas(64) std::atomic<int64_t> top{0};
+  alignas(64) std::atomic<int64_t> bottom{0};
+  std::atomic<ring *> buffer{nullptr};
+  std::vector<std::unique_ptr<ring>> rings;
+};
+
+} // namespace gc
+
+#endif